@@ -0,0 +1,310 @@
+#include "MemoryTool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <linux/hw_breakpoint.h>
+#include <linux/perf_event.h>
+
+// ==============================================================================================
+// Access Tracer
+// ==============================================================================================
+
+static const int TRACE_POLL_MS = 50;       // Longest a sample waits in its ring
+static const int TRACE_SWEEP_MS = 500;     // How often new threads are looked for
+
+static size_t PageSize() {
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return page;
+}
+
+static std::vector<int> ListThreads(int pid) {
+    std::vector<int> tids;
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/task", pid);
+    DIR* dir = opendir(path);
+    if (!dir) return tids;
+    while (struct dirent* entry = readdir(dir)) {
+        int tid = atoi(entry->d_name);
+        if (tid > 0) tids.push_back(tid);
+    }
+    closedir(dir);
+    return tids;
+}
+
+bool AccessTracer::Start(int pid, ADDRESS addr, size_t len, int kind) {
+    Stop();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_sites.clear();
+        m_resolved.clear();
+        m_stats = TraceStats();
+        m_error.clear();
+    }
+
+    // Watchpoints cover an aligned 1, 2, 4 or 8 bytes
+    uint64_t bpLen = len <= 1 ? 1 : len <= 2 ? 2 : len <= 4 ? 4 : 8;
+    uint64_t bpAddr = addr;
+    if (len > 8 || bpAddr % bpLen) {
+        bpAddr = addr & ~(ADDRESS)7;
+        bpLen = 8;
+        if (len > 8 || addr + len > bpAddr + 8) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_error = "range crosses an 8-byte boundary";
+            return false;
+        }
+    }
+
+    m_pid = pid;
+    m_addr = addr;
+    m_bpAddr = bpAddr;
+    m_bpLen = bpLen;
+    m_kind = kind;
+    Sweep();
+    if (m_rings.empty()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_error.empty()) m_error = "no thread of the target could be armed";
+        printf("[-] Access trace on 0x%lX failed: %s\n", (unsigned long)addr, m_error.c_str());
+        return false;
+    }
+    printf("[+] Tracing %s of 0x%lX on %zu threads\n", kind == TRACE_WRITES ? "writes" : "accesses",
+           (unsigned long)addr, m_rings.size());
+    m_running = true;
+    m_thread = std::thread(&AccessTracer::CollectLoop, this);
+    return true;
+}
+
+void AccessTracer::Stop() {
+    m_running = false;
+    if (m_thread.joinable()) m_thread.join();
+    for (auto& ring : m_rings) {
+        Drain(ring.second);
+        Disarm(ring.second);
+    }
+    m_rings.clear();
+}
+
+void AccessTracer::LastError(char* out, size_t size) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    snprintf(out, size, "%s", m_error.c_str());
+}
+
+bool AccessTracer::Arm(int tid) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_BREAKPOINT;
+    attr.bp_type = m_kind == TRACE_WRITES ? HW_BREAKPOINT_W : HW_BREAKPOINT_RW;
+    attr.bp_addr = m_bpAddr;
+    attr.bp_len = m_bpLen;
+    attr.sample_period = 1;
+    attr.sample_type = PERF_SAMPLE_IP | PERF_SAMPLE_TID;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    // Wake the collector at half a ring; quieter rings are drained on the poll timeout
+    attr.watermark = 1;
+    attr.wakeup_watermark = (uint32_t)(RING_PAGES * PageSize() / 2);
+
+    int fd = (int)syscall(__NR_perf_event_open, &attr, tid, -1, -1, PERF_FLAG_FD_CLOEXEC);
+    if (fd < 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.armFailures++;
+        m_error = std::string("perf_event_open: ") + strerror(errno);
+        return false;
+    }
+    size_t bytes = (RING_PAGES + 1) * PageSize();
+    void* base = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (base == MAP_FAILED) {
+        close(fd);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.armFailures++;
+        m_error = std::string("perf ring mmap: ") + strerror(errno);
+        return false;
+    }
+    Ring& ring = m_rings[tid];
+    ring.fd = fd;
+    ring.base = base;
+    return true;
+}
+
+void AccessTracer::Disarm(Ring& ring) {
+    if (ring.base) munmap(ring.base, (RING_PAGES + 1) * PageSize());
+    if (ring.fd >= 0) close(ring.fd);
+    ring.base = nullptr;
+    ring.fd = -1;
+}
+
+void AccessTracer::Sweep() {
+    std::vector<int> tids = ListThreads(m_pid);
+    std::sort(tids.begin(), tids.end());
+    for (auto it = m_rings.begin(); it != m_rings.end();) {
+        if (!std::binary_search(tids.begin(), tids.end(), it->first)) {
+            Drain(it->second);
+            Disarm(it->second);
+            it = m_rings.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (int tid : tids) {
+        if (!m_rings.count(tid)) Arm(tid);
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.threads = m_rings.size();
+}
+
+// Consumes every record between the ring's tail and head. Records may wrap around the end of
+// the data area, so each is copied out before it is parsed.
+void AccessTracer::Drain(Ring& ring) {
+    if (!ring.base) return;
+    auto* meta = (struct perf_event_mmap_page*)ring.base;
+    const uint8_t* data = (const uint8_t*)ring.base + PageSize();
+    const uint64_t size = RING_PAGES * PageSize();
+
+    uint64_t head = __atomic_load_n(&meta->data_head, __ATOMIC_ACQUIRE);
+    uint64_t tail = meta->data_tail;
+    if (head == tail) return;
+
+    uint64_t samples = 0, lost = 0, throttles = 0;
+    std::vector<std::pair<uint64_t, int>> hits; // pc, tid
+    uint8_t record[256];
+    while (tail < head) {
+        struct perf_event_header header;
+        for (size_t k = 0; k < sizeof(header); k++) ((uint8_t*)&header)[k] = data[(tail + k) & (size - 1)];
+        if (header.size < sizeof(header) || tail + header.size > head) break;
+        size_t copy = std::min<size_t>(header.size, sizeof(record));
+        for (size_t k = 0; k < copy; k++) record[k] = data[(tail + k) & (size - 1)];
+        const uint8_t* body = record + sizeof(header);
+
+        switch (header.type) {
+            case PERF_RECORD_SAMPLE: {
+                uint64_t ip;
+                uint32_t pidTid[2];
+                memcpy(&ip, body, sizeof(ip));
+                memcpy(pidTid, body + sizeof(ip), sizeof(pidTid));
+                hits.push_back({ ip, (int)pidTid[1] });
+                samples++;
+                break;
+            }
+            case PERF_RECORD_LOST: {
+                uint64_t count;
+                memcpy(&count, body + sizeof(uint64_t), sizeof(count)); // After the event id
+                lost += count;
+                break;
+            }
+            case PERF_RECORD_THROTTLE:
+                throttles++;
+                break;
+        }
+        tail += header.size;
+    }
+    __atomic_store_n(&meta->data_tail, tail, __ATOMIC_RELEASE);
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& hit : hits) {
+        Site& site = m_sites[hit.first];
+        site.hits++;
+        if (std::find(site.tids.begin(), site.tids.end(), hit.second) == site.tids.end()) site.tids.push_back(hit.second);
+    }
+    m_stats.samples += samples;
+    m_stats.lost += lost;
+    m_stats.throttles += throttles;
+}
+
+void AccessTracer::CollectLoop() {
+    std::vector<struct pollfd> fds;
+    std::vector<Ring*> rings;
+    auto nextSweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(TRACE_SWEEP_MS);
+
+    while (m_running) {
+        fds.clear();
+        rings.clear();
+        for (auto& ring : m_rings) {
+            fds.push_back({ ring.second.fd, POLLIN, 0 });
+            rings.push_back(&ring.second);
+        }
+        poll(fds.data(), fds.size(), TRACE_POLL_MS);
+        // Drain all rings, not only the signalled ones: below the watermark nothing signals
+        for (Ring* ring : rings) Drain(*ring);
+
+        if (std::chrono::steady_clock::now() >= nextSweep) {
+            if (kill(m_pid, 0) != 0 && errno == ESRCH) break; // Target exited
+            Sweep();
+            nextSweep = std::chrono::steady_clock::now() + std::chrono::milliseconds(TRACE_SWEEP_MS);
+        }
+    }
+    m_running = false;
+}
+
+// Resolves pcs to module+offset from the maps line holding each: the mapping's file offset
+// plus the distance into it. Code mappings rarely move, so a pc is resolved once per trace.
+void AccessTracer::Sites(std::vector<AccessSite>& sites) {
+    std::vector<size_t> unresolved;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        sites.resize(m_sites.size());
+        size_t i = 0;
+        for (const auto& entry : m_sites) {
+            AccessSite& site = sites[i];
+            site.pc = entry.first;
+            site.hits = entry.second.hits;
+            site.threads = (uint32_t)entry.second.tids.size();
+            auto known = m_resolved.find(site.pc);
+            if (known != m_resolved.end()) {
+                site.module.assign(known->second.first);
+                site.offset = known->second.second;
+            } else {
+                site.module.clear();
+                site.offset = 0;
+                unresolved.push_back(i);
+            }
+            i++;
+        }
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/maps", m_pid);
+    FILE* fp = unresolved.empty() ? nullptr : fopen(path, "r");
+    if (fp) {
+        char line[1024];
+        while (fgets(line, sizeof(line), fp)) {
+            unsigned long long start, end, fileOffset;
+            char perms[8];
+            int nameAt = 0;
+            if (sscanf(line, "%llx-%llx %7s %llx %*s %*s %n", &start, &end, perms, &fileOffset, &nameAt) < 4) continue;
+            for (size_t i : unresolved) {
+                AccessSite& site = sites[i];
+                if (site.pc < start || site.pc >= end) continue;
+                std::string name = nameAt ? line + nameAt : "";
+                while (!name.empty() && (name.back() == '\n' || name.back() == ' ')) name.pop_back();
+                size_t slash = name.rfind('/');
+                site.module = slash == std::string::npos ? name : name.substr(slash + 1);
+                site.offset = site.pc - start + fileOffset;
+            }
+        }
+        fclose(fp);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (size_t i : unresolved) m_resolved[sites[i].pc] = { sites[i].module, sites[i].offset };
+    }
+
+    std::sort(sites.begin(), sites.end(), [](const AccessSite& a, const AccessSite& b) {
+        return a.hits != b.hits ? a.hits > b.hits : a.pc < b.pc;
+    });
+}
+
+TraceStats AccessTracer::Stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void AccessTracer::ClearSites() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_sites.clear();
+}
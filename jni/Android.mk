@@ -22,7 +22,7 @@ FILE_LIST += $(wildcard $(LOCAL_PATH)/$(OVERLAY_PATH)/ImGui/backends/*.cpp)
 FILE_LIST += $(wildcard $(LOCAL_PATH)/$(OVERLAY_PATH)/native_surface/*.cpp)
 
 # MemoryTool Sources
-LOCAL_SRC_FILES := main.cpp MemoryTool.cpp $(FILE_LIST:$(LOCAL_PATH)/%=%)
+LOCAL_SRC_FILES := main.cpp MemoryTool.cpp ResultStore.cpp ChunkReader.cpp ScanArena.cpp AccessTracer.cpp ValueCache.cpp RenderScheduler.cpp Benchmarks.cpp $(FILE_LIST:$(LOCAL_PATH)/%=%)
 
 # Compilation Flags
 LOCAL_CFLAGS += -w -s -fvisibility=hidden -fpermissive -fexceptions
@@ -0,0 +1,387 @@
+#include "Benchmarks.h"
+#include "MemoryTool.h"
+#include "imgui.h"
+#include "imgui_internal.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <unistd.h>
+
+// ==============================================================================================
+// Scan Kernels
+// ==============================================================================================
+
+static const size_t BENCH_BUFFER_SIZE = 64 * 1024 * 1024;
+static const int BENCH_ROUNDS = 3;
+
+// The compare loop scans used before the kernel registry: type and operator are runtime
+// values, so every element pays for both branches
+static size_t LegacyScan(const uint8_t* buf, size_t len, int type, int op, const ScanOperand& operand, size_t stride, uint32_t* out) {
+    const size_t size = MemoryTool::GetTypeInfo(type).size;
+    size_t n = 0;
+    for (size_t i = 0; i + size <= len; i += stride) {
+        bool match = false;
+        switch (type) {
+            case TYPE_DWORD: {
+                DWORD v, a, b; memcpy(&v, buf + i, 4); memcpy(&a, &operand.a, 4); memcpy(&b, &operand.b, 4);
+                match = op == OP_EQ ? v == a : (v >= a && v <= b);
+                break;
+            }
+            case TYPE_FLOAT: {
+                FLOAT v, a, b; memcpy(&v, buf + i, 4); memcpy(&a, &operand.a, 4); memcpy(&b, &operand.b, 4);
+                match = op == OP_EQ ? v == a : (v >= a && v <= b);
+                break;
+            }
+            case TYPE_DOUBLE: {
+                DOUBLE v, a, b; memcpy(&v, buf + i, 8); memcpy(&a, &operand.a, 8); memcpy(&b, &operand.b, 8);
+                match = op == OP_EQ ? v == a : (v >= a && v <= b);
+                break;
+            }
+            case TYPE_WORD: {
+                WORD v, a, b; memcpy(&v, buf + i, 2); memcpy(&a, &operand.a, 2); memcpy(&b, &operand.b, 2);
+                match = op == OP_EQ ? v == a : (v >= a && v <= b);
+                break;
+            }
+        }
+        if (match) out[n++] = (uint32_t)i;
+    }
+    return n;
+}
+
+template <typename Fn>
+static double BestMBps(Fn&& fn) {
+    double best = 0;
+    for (int r = 0; r < BENCH_ROUNDS; r++) {
+        auto start = std::chrono::steady_clock::now();
+        fn();
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        double mbps = BENCH_BUFFER_SIZE / (1024.0 * 1024.0) / sec;
+        if (mbps > best) best = mbps;
+    }
+    return best;
+}
+
+int RunScanKernelBenchmark() {
+    // Mostly small integers with sparse planted matches, like a typical heap
+    std::vector<uint8_t> buf(BENCH_BUFFER_SIZE);
+    uint32_t seed = 12345;
+    for (size_t i = 0; i < buf.size(); i += 4) {
+        seed = seed * 1664525u + 1013904223u;
+        uint32_t v = (seed >> 8) & 0xFF;
+        if ((seed & 0xFFF) == 0) v = 123456789;
+        memcpy(&buf[i], &v, 4);
+    }
+
+    struct Case { const char* name; int type; int op; const char* a; const char* b; };
+    const Case cases[] = {
+        { "DWORD  ==",    TYPE_DWORD,  OP_EQ,    "123456789", nullptr },
+        { "DWORD  range", TYPE_DWORD,  OP_RANGE, "100", "120" },
+        { "FLOAT  range", TYPE_FLOAT,  OP_RANGE, "1.0", "2.0" },
+        { "DOUBLE ==",    TYPE_DOUBLE, OP_EQ,    "42.25", nullptr },
+        { "WORD   ==",    TYPE_WORD,   OP_EQ,    "777", nullptr },
+    };
+
+    std::vector<uint32_t> legacyOut(buf.size() + 1);
+    std::vector<uint32_t> kernelOut(buf.size() + 1);
+    int failures = 0;
+
+    printf("Scan kernels, %zu MB buffer, best of %d\n", BENCH_BUFFER_SIZE / (1024 * 1024), BENCH_ROUNDS);
+    printf("%-14s %12s %12s %8s %10s\n", "case", "legacy MB/s", "kernel MB/s", "speedup", "hits");
+    for (const auto& c : cases) {
+        size_t stride = MemoryTool::GetTypeInfo(c.type).size;
+        if (stride > 4) stride = 4;
+        ScanOperand operand = MemoryTool::MakeOperand(c.op, c.type, c.a, c.b);
+        ScanKernelFn kernel = MemoryTool::GetKernel(c.type, c.op, stride);
+
+        size_t legacyHits = 0, kernelHits = 0;
+        double legacy = BestMBps([&] { legacyHits = LegacyScan(buf.data(), buf.size(), c.type, c.op, operand, stride, legacyOut.data()); });
+        double fast = BestMBps([&] { kernelHits = kernel(buf.data(), buf.size(), operand, kernelOut.data()); });
+
+        bool same = legacyHits == kernelHits && memcmp(legacyOut.data(), kernelOut.data(), kernelHits * sizeof(uint32_t)) == 0;
+        if (!same) failures++;
+        printf("%-14s %12.0f %12.0f %7.1fx %10zu%s\n", c.name, legacy, fast, fast / legacy, kernelHits, same ? "" : "  MISMATCH");
+    }
+    return failures ? 1 : 0;
+}
+
+// ==============================================================================================
+// Result Sets
+// ==============================================================================================
+
+static const size_t BENCH_SET_ROWS = 20 * 1000 * 1000;
+
+// Rows every 'step' bytes over 64 MB maps, so both sets agree on which map holds an address
+static void FillBenchSet(ResultStore& store, ADDRESS step) {
+    const ADDRESS BASE = 0x7000000000, MAP_SIZE = 64 * 1024 * 1024;
+    std::vector<ADDRESS> batch;
+    store.Clear();
+    store.type = TYPE_DWORD;
+    store.Reserve(BENCH_SET_ROWS);
+    ADDRESS addr = BASE;
+    for (size_t row = 0; row < BENCH_SET_ROWS;) {
+        size_t map = (addr - BASE) / MAP_SIZE;
+        batch.clear();
+        while (row < BENCH_SET_ROWS && (addr - BASE) / MAP_SIZE == map) {
+            batch.push_back(addr);
+            addr += step;
+            row++;
+        }
+        store.Append(batch.data(), batch.size(), "[anon:bench-" + std::to_string(map) + "]");
+    }
+}
+
+int RunResultSetBenchmark() {
+    ResultStore a, b;
+    FillBenchSet(a, 8);
+    FillBenchSet(b, 12);
+
+    struct Case { const char* name; int op; };
+    const Case cases[] = {
+        { "intersect",  SET_INTERSECT },
+        { "union",      SET_UNION },
+        { "difference", SET_DIFFERENCE },
+    };
+
+    int failures = 0;
+    printf("Result sets, %zu x %zu rows\n", a.Size(), b.Size());
+    printf("%-12s %10s %10s\n", "op", "ms", "rows");
+    for (const auto& c : cases) {
+        ResultStore out;
+        auto start = std::chrono::steady_clock::now();
+        ResultStore::Combine(a, b, c.op, out);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        // a holds multiples of 8, b multiples of 12 (same base): the overlap is every third row of a
+        size_t expect = c.op == SET_INTERSECT ? (BENCH_SET_ROWS + 2) / 3
+                      : c.op == SET_DIFFERENCE ? BENCH_SET_ROWS - (BENCH_SET_ROWS + 2) / 3
+                      : 2 * BENCH_SET_ROWS - (BENCH_SET_ROWS + 2) / 3;
+        bool ok = out.Size() == expect && out.IsSorted();
+        if (!ok) failures++;
+        printf("%-12s %10.1f %10zu%s\n", c.name, ms, out.Size(), ok ? "" : "  MISMATCH");
+    }
+    return failures ? 1 : 0;
+}
+
+// ==============================================================================================
+// Result Files
+// ==============================================================================================
+
+int RunResultFileBenchmark(const char* path) {
+    const size_t ROWS = 10 * 1000 * 1000;
+    ResultStore store;
+    store.type = TYPE_DWORD;
+    store.Reserve(ROWS);
+    store.EnableValues(4);
+    std::vector<ADDRESS> addrs(ROWS);
+    std::vector<uint32_t> values(ROWS);
+    for (size_t i = 0; i < ROWS; i++) {
+        addrs[i] = 0x7000000000 + i * 8;
+        values[i] = (uint32_t)i;
+    }
+    store.Append(addrs.data(), ROWS, "[anon:bench]");
+    store.AppendValues((const uint8_t*)values.data(), ROWS);
+
+    TargetFingerprint target;
+    auto start = std::chrono::steady_clock::now();
+    bool ok = store.WriteFile(path, target);
+    double saveMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    ResultStore loaded;
+    start = std::chrono::steady_clock::now();
+    ok = ok && loaded.MapFile(path, &target);
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    // Touch every row once so the first-access cost shows next to the map itself
+    start = std::chrono::steady_clock::now();
+    ok = ok && loaded.Size() == ROWS && memcmp(loaded.Addrs(), store.Addrs(), ROWS * sizeof(ADDRESS)) == 0 &&
+         memcmp(loaded.Values(), store.Values(), ROWS * 4) == 0 && loaded.RegionName(ROWS - 1) == "[anon:bench]";
+    double verifyMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    unlink(path);
+
+    printf("Result file, %zu rows with values\n", ROWS);
+    printf("save %.1f ms, map %.2f ms, first full read %.1f ms%s\n", saveMs, loadMs, verifyMs, ok ? "" : "  MISMATCH");
+    return ok ? 0 : 1;
+}
+
+// ==============================================================================================
+// UI Frames
+// ==============================================================================================
+
+// Heap allocations are counted on the thread that turns counting on, so the tool's worker
+// threads never show up in a frame. ImGui's allocator is hooked at run time; counting operator
+// new means replacing it for the whole binary, so only bench builds do that:
+//   ndk-build APP_CFLAGS=-DMEMTOOL_BENCH_ALLOC
+static thread_local bool t_countAllocations = false;
+static uint64_t g_newCalls = 0;
+static uint64_t g_imguiAllocs = 0;
+
+#ifdef MEMTOOL_BENCH_ALLOC
+static const bool COUNTS_NEW = true;
+
+void* operator new(size_t size) {
+    if (t_countAllocations) g_newCalls++;
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+#else
+static const bool COUNTS_NEW = false;
+#endif
+
+static void* CountingImGuiAlloc(size_t size, void*) {
+    if (t_countAllocations) g_imguiAllocs++;
+    return malloc(size);
+}
+static void CountingImGuiFree(void* p, void*) { free(p); }
+
+static const char* BENCH_WINDOW = "Memory Tool (KPM) v2.0";
+
+// Opens a tree node or collapsing header as if it had been tapped; 'seed' is the ID on top of
+// the stack where it is drawn: the window's, or a tab's
+static void OpenNode(ImGuiWindow* window, ImGuiID seed, const char* label) {
+    window->StateStorage.SetInt(ImHashStr(label, 0, seed), 1);
+}
+
+// Makes 'name' the selected tab of the main tab bar from the next frame on; returns its ID
+static ImGuiID SelectTab(const char* name) {
+    ImGuiContext& g = *GImGui;
+    for (int n = 0; n < g.TabBars.GetMapSize(); n++) {
+        ImGuiTabBar* bar = g.TabBars.TryGetMapData(n);
+        if (!bar) continue;
+        for (ImGuiTabItem& tab : bar->Tabs) {
+            if (strcmp(bar->GetTabName(&tab), name) == 0) {
+                bar->NextSelectedTabId = tab.ID;
+                return tab.ID;
+            }
+        }
+    }
+    return 0;
+}
+
+int RunUiFrameBenchmark(MemoryTool& tool, void (*drawFrame)()) {
+    const size_t ROWS = 1000 * 1000;
+    const int WARMUP_FRAMES = 120, FRAMES = 600;
+
+    // The tool is attached to this process, so every list shows live values it can read
+    std::vector<uint32_t> memory(ROWS);
+    for (size_t i = 0; i < ROWS; i++) memory[i] = (uint32_t)(i * 7);
+    if (!tool.kpm.init(getpid(), BACKEND_USER)) {
+        printf("UI frames: cannot attach to this process\n");
+        return 1;
+    }
+    if (FILE* fp = fopen("/proc/self/cmdline", "r")) { // The watch sampler looks the target up by name
+        char name[256] = "";
+        fgets(name, sizeof(name), fp);
+        fclose(fp);
+        tool.m_pkgName = name;
+    }
+    {
+        std::vector<ADDRESS> addrs(ROWS);
+        for (size_t i = 0; i < ROWS; i++) addrs[i] = (ADDRESS)(uintptr_t)&memory[i];
+        ResultStore store;
+        store.type = TYPE_DWORD;
+        store.Append(addrs.data(), ROWS / 2, "[anon:bench-a]");
+        store.Append(addrs.data() + ROWS / 2, ROWS - ROWS / 2, "[anon:bench-b]");
+        std::lock_guard<std::mutex> lock(tool.m_resultsMutex);
+        tool.m_results.Swap(store);
+    }
+    tool.SaveResultSet("bench");
+    for (size_t i = 0; i < 16; i++) {
+        tool.AddWatchItem((ADDRESS)(uintptr_t)&memory[i * 4096], TYPE_DWORD);
+        tool.AddFreezeItem((ADDRESS)(uintptr_t)&memory[ROWS - 1 - i], "12345", TYPE_DWORD);
+    }
+    tool.StartWatch();
+    tool.StartFreeze();
+
+    ImGui::SetAllocatorFunctions(CountingImGuiAlloc, CountingImGuiFree);
+    ImGui::CreateContext();
+    ImGuiIO& io = ImGui::GetIO();
+    io.IniFilename = NULL;
+    io.DisplaySize = ImVec2(1280, 900);
+    io.DeltaTime = 1.0f / 60.0f;
+    unsigned char* pixels;
+    int width, height;
+    io.Fonts->GetTexDataAsRGBA32(&pixels, &width, &height); // Builds the atlas; nothing uploads it
+
+    struct Frame { double ms; uint64_t news; uint64_t imguiAllocs; };
+    std::vector<Frame> frames(FRAMES);
+    auto drawOne = [&](Frame* out) {
+        uint64_t news = g_newCalls, imguiAllocs = g_imguiAllocs;
+        auto start = std::chrono::steady_clock::now();
+        t_countAllocations = out != nullptr;
+        ImGui::NewFrame();
+        drawFrame();
+        ImGui::Render();
+        t_countAllocations = false;
+        if (out) {
+            out->ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            out->news = g_newCalls - news;
+            out->imguiAllocs = g_imguiAllocs - imguiAllocs;
+        }
+    };
+    drawOne(nullptr); // Creates the window and its tab bar
+    ImGuiWindow* window = ImGui::FindWindowByName(BENCH_WINDOW);
+    if (!window) {
+        printf("UI frames: no \"%s\" window was drawn\n", BENCH_WINDOW);
+        ImGui::DestroyContext();
+        return 1;
+    }
+    OpenNode(window, window->ID, "##MemoryUsage");
+
+    struct Tab { const char* name; const char* headers[2]; };
+    const Tab tabs[] = {
+        { "Connection", { nullptr, nullptr } },
+        { "Search",     { nullptr, nullptr } },
+        { "Results",    { "Saved Sets", "Sort & Filter" } },
+        { "Watch",      { "Access Trace", nullptr } },
+        { "Frozen",     { nullptr, nullptr } },
+    };
+
+    uint64_t steadyAllocs = 0;
+    printf("UI frames, %zu result rows, 16 watched and 16 frozen values, %d frames per tab\n", ROWS, FRAMES);
+    if (!COUNTS_NEW) printf("operator new is not counted; build with -DMEMTOOL_BENCH_ALLOC for new/frame\n");
+    printf("%-12s %9s %9s %9s %11s %11s %9s\n", "tab", "avg ms", "p99 ms", "max ms", "new/frame", "imgui/frame", "vertices");
+    for (const Tab& tab : tabs) {
+        ImGuiID tabId = SelectTab(tab.name);
+        for (const char* header : tab.headers) {
+            if (header) OpenNode(window, tabId, header);
+        }
+        for (int k = 0; k < WARMUP_FRAMES; k++) drawOne(nullptr);
+        for (int k = 0; k < FRAMES; k++) drawOne(&frames[k]);
+
+        double total = 0, worst = 0;
+        uint64_t news = 0, imguiAllocs = 0;
+        std::vector<double> times(FRAMES);
+        for (int k = 0; k < FRAMES; k++) {
+            total += frames[k].ms;
+            worst = std::max(worst, frames[k].ms);
+            news += frames[k].news;
+            imguiAllocs += frames[k].imguiAllocs;
+            times[k] = frames[k].ms;
+        }
+        std::sort(times.begin(), times.end());
+        steadyAllocs += news + imguiAllocs;
+        char newPerFrame[16] = "-";
+        if (COUNTS_NEW) snprintf(newPerFrame, sizeof(newPerFrame), "%.2f", (double)news / FRAMES);
+        printf("%-12s %9.3f %9.3f %9.3f %11s %11.2f %9d\n", tab.name, total / FRAMES, times[FRAMES * 99 / 100], worst,
+               newPerFrame, (double)imguiAllocs / FRAMES, ImGui::GetDrawData()->TotalVtxCount);
+    }
+
+    ImGui::DestroyContext();
+    tool.StopWatch();
+    tool.StopFreeze();
+    tool.ClearFreezeItems();
+    tool.ClearWatchItems();
+    tool.m_valueCache.Stop();
+    return steadyAllocs ? 1 : 0;
+}
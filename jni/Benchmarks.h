@@ -0,0 +1,27 @@
+#pragma once
+
+class MemoryTool;
+
+// Headless benchmarks, run from the command line instead of the overlay:
+//   memory_tool --bench-kernels
+//   memory_tool --bench-sets
+//   memory_tool --bench-files [path]
+//   memory_tool --bench-ui
+
+// Legacy per-element compare loop vs. specialized scan kernels, in MB/s. Returns 0 when all
+// kernels agree with the reference loop, 1 otherwise.
+int RunScanKernelBenchmark();
+
+// Intersection / union / difference of two 20M-row result sets. Returns 0 when every output
+// has the expected size and order.
+int RunResultSetBenchmark();
+
+// Save and reload a 10M-row result set with a value column through 'path'. Returns 0 when the
+// mapped copy matches the original.
+int RunResultFileBenchmark(const char* path);
+
+// Draws 'drawFrame' between ImGui::NewFrame and Render with no GPU backend, each tab in turn,
+// against a 1M-row result set, watch and freeze lists in this process. Prints frame times and
+// heap allocations per frame on the UI thread: ImGui's allocator always, operator new only in
+// builds with -DMEMTOOL_BENCH_ALLOC. Returns 0 when steady-state frames allocate nothing.
+int RunUiFrameBenchmark(MemoryTool& tool, void (*drawFrame)());
@@ -0,0 +1,325 @@
+#include "MemoryTool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <sys/utsname.h>
+#ifdef __ANDROID__
+#include <sys/system_properties.h>
+#endif
+
+// ==============================================================================================
+// Chunk Reader
+// ==============================================================================================
+
+ChunkReader::ChunkReader(KPMClient& kpm, ScanArena& arena, const std::vector<MemoryMap>& maps, size_t chunkSize, size_t depth, size_t readers)
+    : m_kpm(kpm), m_depth(depth > 1 ? depth : 1) {
+    for (const auto& map : maps) {
+        for (ADDRESS a = map.startAddr; a < map.endAddr; a += chunkSize) {
+            m_chunks.push_back({ &map, a, (size_t)std::min<ADDRESS>(chunkSize, map.endAddr - a), 0, nullptr });
+        }
+    }
+    if (m_depth == 1) readers = 0;
+    else if (readers == 0) readers = 1;
+    if (readers > m_depth) readers = m_depth;
+
+    for (size_t b = 0; b < m_depth; b++) m_buffers.push_back(arena.Acquire<uint8_t>(chunkSize));
+    m_slotChunk.assign(m_depth, SIZE_MAX);
+    m_stats.depth = (uint32_t)m_depth;
+    m_stats.readers = (uint32_t)readers;
+    for (size_t r = 0; r < readers; r++) m_readers.emplace_back(&ChunkReader::ReaderLoop, this);
+}
+
+ChunkReader::~ChunkReader() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_slotFree.notify_all();
+    for (auto& reader : m_readers) reader.join();
+}
+
+void ChunkReader::ReaderLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_stop && m_nextRead < m_chunks.size()) {
+        size_t i = m_nextRead++;
+        // Chunk i reuses the buffer of chunk i - depth, so that one must be released first
+        if (i >= Released() + m_depth) {
+            auto start = std::chrono::steady_clock::now();
+            m_stats.readerStalls++;
+            m_slotFree.wait(lock, [&] { return m_stop || i < Released() + m_depth; });
+            m_stats.readerWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            if (m_stop) break;
+        }
+        lock.unlock();
+
+        Chunk& chunk = m_chunks[i];
+        uint8_t* buffer = m_buffers[i % m_depth].data();
+        chunk.bytesRead = m_kpm.read_raw(chunk.addr, buffer, chunk.size);
+        chunk.data = buffer;
+
+        lock.lock();
+        m_slotChunk[i % m_depth] = i;
+        m_chunkReady.notify_one();
+    }
+}
+
+const ChunkReader::Chunk* ChunkReader::Next() {
+    if (m_readers.empty()) {
+        if (m_nextConsume >= m_chunks.size()) return nullptr;
+        Chunk& chunk = m_chunks[m_nextConsume++];
+        chunk.bytesRead = m_kpm.read_raw(chunk.addr, m_buffers[0].data(), chunk.size);
+        chunk.data = m_buffers[0].data();
+        m_stats.chunks++;
+        if (chunk.bytesRead < chunk.size) m_stats.shortReads++;
+        return &chunk;
+    }
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    if (m_nextConsume >= m_chunks.size()) return nullptr;
+    size_t i = m_nextConsume++;
+    m_slotFree.notify_all(); // Chunk i - 1 is released
+    if (m_slotChunk[i % m_depth] != i) {
+        auto start = std::chrono::steady_clock::now();
+        m_stats.compareStalls++;
+        m_chunkReady.wait(lock, [&] { return m_slotChunk[i % m_depth] == i; });
+        m_stats.compareWaitMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    m_stats.chunks++;
+    if (m_chunks[i].bytesRead < m_chunks[i].size) m_stats.shortReads++;
+    return &m_chunks[i];
+}
+
+PipelineStats ChunkReader::Stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+// ==============================================================================================
+// Chunk Tuner
+// ==============================================================================================
+
+static const char* TUNE_CACHE_PATH = "/data/local/tmp/memtool_tune.txt"; // "<chunk> <slice> <device>" per line
+static const size_t TUNE_SAMPLE_BYTES = 8 * 1024 * 1024; // Per size and round, in spans of the largest size
+
+int ChunkTuner::IndexOf(size_t size) {
+    for (int i = 0; i < SIZES; i++) {
+        if (SizeOf(i) == size) return i;
+    }
+    return -1;
+}
+
+bool ChunkTuner::Observe(Lane& lane, size_t sizeUsed, uint64_t bytes, double ms, uint64_t chunks, uint64_t shortReads) {
+    const int i = IndexOf(sizeUsed);
+    const bool wasProbe = i >= 0 && i == lane.probe;
+    lane.probe = -1;
+    if (i < 0 || bytes < MIN_SAMPLE_BYTES || ms <= 0) return false;
+
+    const double mbps = bytes / (1024.0 * 1024.0) / (ms / 1000.0);
+    lane.mbps[i] = lane.mbps[i] > 0 ? lane.mbps[i] * 0.7 + mbps * 0.3 : mbps;
+
+    const int home = lane.home;
+    if (chunks && shortReads * 50 > chunks) {
+        // Over 2% of the chunks hit an unreadable page and lost their tail; smaller chunks lose less
+        if (i > 0 && i <= home) lane.home = i - 1;
+        lane.probeUp = false;
+    } else if (wasProbe) {
+        // Keep climbing while it pays; a probe that lost turns the next one around
+        if (lane.mbps[i] > lane.mbps[home] * 1.05) lane.home = i;
+        else lane.probeUp = !lane.probeUp;
+    } else if (++lane.scans % PROBE_EVERY == 0) {
+        int next = lane.home + (lane.probeUp ? 1 : -1);
+        if (next < 0 || next >= SIZES) {
+            lane.probeUp = !lane.probeUp;
+            next = lane.home + (lane.probeUp ? 1 : -1);
+        }
+        lane.probe = next;
+    }
+    return lane.home != home;
+}
+
+std::string MemoryTool::GetDeviceFingerprint() {
+    std::string id = kpm.get_backend() == BACKEND_USER ? "user" : (kpm.supports_search_ops() ? "kpm+ops" : "kpm");
+    struct utsname uts;
+    if (uname(&uts) == 0) {
+        id += '|';
+        id += uts.release;
+        id += '|';
+        id += uts.machine;
+    }
+#ifdef __ANDROID__
+    char build[PROP_VALUE_MAX] = {};
+    if (__system_property_get("ro.build.fingerprint", build) > 0) {
+        id += '|';
+        id += build;
+    }
+#endif
+    for (char& c : id) {
+        if (c == '\n' || c == '\r') c = ' ';
+    }
+    return id;
+}
+
+// Cached sizes of 'device', if any
+static bool FindTuneCache(const std::string& device, size_t& chunk, size_t& slice) {
+    FILE* fp = fopen(TUNE_CACHE_PATH, "r");
+    if (!fp) return false;
+    bool found = false;
+    char line[512];
+    while (fgets(line, sizeof(line), fp)) {
+        size_t c = 0, s = 0;
+        int n = 0;
+        if (sscanf(line, "%zu %zu %n", &c, &s, &n) != 2 || n == 0) continue;
+        std::string id(line + n);
+        while (!id.empty() && (id.back() == '\n' || id.back() == '\r')) id.pop_back();
+        if (id == device && ChunkTuner::IndexOf(c) >= 0 && ChunkTuner::IndexOf(s) >= 0) {
+            chunk = c;
+            slice = s;
+            found = true;
+        }
+    }
+    fclose(fp);
+    return found;
+}
+
+void MemoryTool::SaveTuneCache() {
+    if (m_tuner.device.empty()) return;
+    // Other devices' lines stay; the file may live on shared storage
+    std::vector<std::string> keep;
+    if (FILE* fp = fopen(TUNE_CACHE_PATH, "r")) {
+        char line[512];
+        while (fgets(line, sizeof(line), fp)) {
+            size_t c = 0, s = 0;
+            int n = 0;
+            if (sscanf(line, "%zu %zu %n", &c, &s, &n) != 2 || n == 0) continue;
+            std::string id(line + n);
+            while (!id.empty() && (id.back() == '\n' || id.back() == '\r')) id.pop_back();
+            if (id != m_tuner.device) keep.push_back(line);
+        }
+        fclose(fp);
+    }
+
+    std::string tmp = std::string(TUNE_CACHE_PATH) + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "w");
+    if (!fp) return;
+    for (const auto& line : keep) fputs(line.c_str(), fp);
+    fprintf(fp, "%zu %zu %s\n", ChunkTuner::SizeOf(m_tuner.read.home), ChunkTuner::SizeOf(m_tuner.slice.home),
+            m_tuner.device.c_str());
+    if (fclose(fp) == 0) rename(tmp.c_str(), TUNE_CACHE_PATH);
+    else remove(tmp.c_str());
+}
+
+// MB/s of walking 'spans' in pieces of 'size', 'pass' returning the bytes it handled per piece
+template <typename Pass>
+static double MeasureSpans(const std::vector<std::pair<ADDRESS, ADDRESS>>& spans, size_t size, Pass pass) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t bytes = 0;
+    for (const auto& span : spans) {
+        for (ADDRESS a = span.first; a < span.second; a += size) {
+            bytes += pass(a, (size_t)std::min<ADDRESS>(size, span.second - a));
+        }
+    }
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return ms > 0 ? bytes / (1024.0 * 1024.0) / (ms / 1000.0) : 0;
+}
+
+void MemoryTool::AutotuneChunks(bool force, double budgetMs) {
+    auto startTime = std::chrono::steady_clock::now();
+    m_tuner = ChunkTuner();
+    m_tuner.device = GetDeviceFingerprint();
+
+    size_t chunk = 0, slice = 0;
+    if (!force && FindTuneCache(m_tuner.device, chunk, slice)) {
+        m_tuner.read.home = ChunkTuner::IndexOf(chunk);
+        m_tuner.slice.home = ChunkTuner::IndexOf(slice);
+        ApplyChunkSizes();
+        printf("Chunk sizes from cache: read %zu KB, search slice %zu KB\n", chunk / 1024, slice / 1024);
+        return;
+    }
+
+    // Sample the largest maps in whole spans of the largest size, so every size reads the same bytes
+    const size_t SPAN = ChunkTuner::SizeOf(ChunkTuner::SIZES - 1);
+    std::vector<MemoryMap> maps = readmaps(m_searchRange);
+    std::sort(maps.begin(), maps.end(), [](const MemoryMap& x, const MemoryMap& y) {
+        return x.endAddr - x.startAddr > y.endAddr - y.startAddr;
+    });
+    std::vector<std::pair<ADDRESS, ADDRESS>> spans;
+    size_t sampled = 0;
+    for (const auto& map : maps) {
+        for (ADDRESS a = map.startAddr; a + SPAN <= map.endAddr && sampled < TUNE_SAMPLE_BYTES; a += SPAN) {
+            spans.push_back({ a, a + SPAN });
+            sampled += SPAN;
+        }
+    }
+    if (spans.empty()) {
+        ApplyChunkSizes();
+        printf("Chunk autotune: no map of %zu KB to sample, keeping defaults\n", SPAN / 1024);
+        return;
+    }
+
+    auto elapsed = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    };
+    std::vector<uint8_t> buffer(SPAN);
+    std::vector<uint32_t> offsets(SPAN / 4 + 1);
+    std::vector<uint64_t> hits(MAX_KERNEL_RES);
+    // A value that should be rare, so the search measures the scan and not result handling
+    ScanOperand operand;
+    operand.a = 0x5EC0A7B3;
+    operand.b = 0;
+    ScanKernelFn kernel = GetKernel(TYPE_DWORD, OP_EQ, 4);
+    kpm_search_query query = MakeQuery(OP_EQ, TYPE_DWORD, operand);
+
+    auto readPass = [&](ADDRESS a, size_t len) {
+        size_t got = kpm.read_raw(a, buffer.data(), len);
+        kernel(buffer.data(), got, operand, offsets.data());
+        return got; // A failed read costs its time and counts nothing
+    };
+    auto slicePass = [&](ADDRESS a, size_t len) {
+        kpm.search_slice(a, len, query, hits.data(), MAX_KERNEL_RES);
+        return len;
+    };
+
+    // First pass only warms the target's pages and our caches. Each size then keeps the best
+    // of up to two rounds; the read lane may use 60% of the budget, the slice lane the rest.
+    MeasureSpans(spans, ChunkTuner::Current(m_tuner.read), readPass);
+    double readMbps[ChunkTuner::SIZES] = {}, sliceMbps[ChunkTuner::SIZES] = {};
+    for (int round = 0; round < 2 && elapsed() < budgetMs * 0.6; round++) {
+        for (int i = 0; i < ChunkTuner::SIZES && elapsed() < budgetMs * 0.6; i++) {
+            readMbps[i] = std::max(readMbps[i], MeasureSpans(spans, ChunkTuner::SizeOf(i), readPass));
+        }
+    }
+    for (int round = 0; round < 2 && elapsed() < budgetMs; round++) {
+        for (int i = 0; i < ChunkTuner::SIZES && elapsed() < budgetMs; i++) {
+            sliceMbps[i] = std::max(sliceMbps[i], MeasureSpans(spans, ChunkTuner::SizeOf(i), slicePass));
+        }
+    }
+    for (int i = 0; i < ChunkTuner::SIZES; i++) {
+        if (readMbps[i] > readMbps[m_tuner.read.home]) m_tuner.read.home = i;
+        if (sliceMbps[i] > sliceMbps[m_tuner.slice.home]) m_tuner.slice.home = i;
+    }
+    ApplyChunkSizes();
+    SaveTuneCache();
+    printf("Chunk autotune: read %zu KB (%.0f MB/s), search slice %zu KB (%.0f MB/s), %zu KB sampled in %.1f ms\n",
+           ChunkTuner::SizeOf(m_tuner.read.home) / 1024, readMbps[m_tuner.read.home],
+           ChunkTuner::SizeOf(m_tuner.slice.home) / 1024, sliceMbps[m_tuner.slice.home], sampled / 1024, elapsed());
+}
+
+void MemoryTool::ApplyChunkSizes() {
+    const bool adapt = m_adaptChunks;
+    const size_t chunkOverride = m_chunkOverride, sliceOverride = m_sliceOverride;
+    auto tuned = [&](const ChunkTuner::Lane& lane) {
+        return adapt ? ChunkTuner::Current(lane) : ChunkTuner::SizeOf(lane.home);
+    };
+    READ_CHUNK_SIZE = chunkOverride ? chunkOverride : tuned(m_tuner.read);
+    kpm.search_slice_max = sliceOverride ? sliceOverride : tuned(m_tuner.slice);
+}
+
+void MemoryTool::ObserveChunkScan(const char* name, ChunkTuner::Lane& lane, size_t override, size_t sizeUsed, uint64_t bytes,
+                                  double ms, uint64_t chunks, uint64_t shortReads) {
+    if (!m_adaptChunks || override) return;
+    if (ChunkTuner::Observe(lane, sizeUsed, bytes, ms, chunks, shortReads)) {
+        printf("%s size now %zu KB (%.0f MB/s at %zu KB)\n", name, ChunkTuner::SizeOf(lane.home) / 1024,
+               lane.mbps[lane.home], sizeUsed / 1024);
+        SaveTuneCache();
+    }
+}
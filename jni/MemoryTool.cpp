@@ -10,6 +10,13 @@
 #include <sstream>
 #include <algorithm>
 #include <iomanip>
+#include <type_traits>
+#include <time.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <cmath>
+#include <chrono>
+#include <limits>
 
 using namespace std;
 
@@ -18,17 +25,30 @@ using namespace std;
 // ==============================================================================================
 
 MemoryTool::~MemoryTool() {
+    StopJobs();
     StopFreeze();
+    StopWatch();
 }
 
-void MemoryTool::initXMemoryTools(const char* pkgName, const char* mode) {
+bool MemoryTool::initXMemoryTools(const char* pkgName, const char* mode, char* error, size_t errorSize) {
+    auto fail = [&](const char* reason) {
+        printf("\033[31;1m[ERROR] %s\033[0m\n", reason);
+        if (error && errorSize) snprintf(error, errorSize, "%s", reason);
+        return false;
+    };
+    if (error && errorSize) error[0] = '\0';
+
+    // Every worker reads m_pkgName or the client's target; none may run across the switch.
+    // Frozen and watched addresses belong to the old process, so those loops stay stopped.
+    StopJobs();
+    StopFreeze();
+    StopWatch();
+    m_valueCache.Stop(); // Restarts with the next rows the overlay shows
+    m_tracer.Stop();
     m_pkgName = pkgName;
 
     if (strcmp(mode, MODE_ROOT) == 0) {
-        if (getuid() != 0) {
-            printf("\033[31;1m[ERROR] This tool requires ROOT access!\033[0m\n");
-            exit(1);
-        }
+        if (getuid() != 0) return fail("This tool requires ROOT access!");
     }
 
     // Try to optimize system for memory operations
@@ -36,15 +56,18 @@ void MemoryTool::initXMemoryTools(const char* pkgName, const char* mode) {
 
     int pid = getPID(pkgName);
     if (pid <= 0) {
-        printf("\033[31;1m[ERROR] Failed to get PID for %s\n\033[0m", pkgName);
-        exit(1);
+        char reason[320];
+        snprintf(reason, sizeof(reason), "Failed to get PID for %s", pkgName);
+        return fail(reason);
     }
 
-    if (!kpm.init(pid)) {
-        printf("\033[31;1m[ERROR] Failed to init KPM driver! Is the kernel module loaded?\033[0m\n");
-        exit(1);
-    }
+    // Without root there is no driver; process_vm_readv still works on targets we may ptrace
+    int backend = (strcmp(mode, MODE_NO_ROOT) == 0) ? BACKEND_USER : BACKEND_KPM;
+    if (!kpm.init(pid, backend)) return fail("Failed to init KPM driver! Is the kernel module loaded?");
     printf("\033[32;1m[OK] KPM Driver Initialized for PID: %d\033[0m\n", pid);
+    // On the job thread: m_tuner belongs to it, and sampling the target would stall the overlay
+    SubmitJob("Autotune", [this]() { AutotuneChunks(); });
+    return true;
 }
 
 int MemoryTool::getPID(const char* pkgName) {
@@ -179,203 +202,973 @@ std::vector<MemoryMap> MemoryTool::readmaps(int type) {
 }
 
 
+// ==============================================================================================
+// Type Table & Kernels
+// ==============================================================================================
+
+// Indexed by DataType
+static const TypeInfo TYPE_INFO[] = {
+    { "DWORD",  4, false, true },
+    { "FLOAT",  4, true,  true },
+    { "DOUBLE", 8, true,  true },
+    { "WORD",   2, false, true },
+    { "BYTE",   1, false, true },
+    { "QWORD",  8, false, true },
+    { "AUTO",   0, false, false }, // No width of its own, so every single-type path rejects it
+};
+static const TypeInfo UNKNOWN_TYPE_INFO = { "UNKNOWN", 0, false, false };
+
+// Same order as DataType, so the DataType value is the registry's type index
+typedef ScanKernelRegistry<DWORD, FLOAT, DOUBLE, WORD, BYTE, QWORD> MemoryKernels;
+
+const TypeInfo& MemoryTool::GetTypeInfo(int type) {
+    if (type < 0 || type >= (int)(sizeof(TYPE_INFO) / sizeof(TYPE_INFO[0]))) return UNKNOWN_TYPE_INFO;
+    return TYPE_INFO[type];
+}
+
+ScanKernelFn MemoryTool::GetKernel(int type, int op, size_t stride) {
+    if (GetTypeInfo(type).size == 0) return nullptr;
+    return MemoryKernels::Get((size_t)type, op, stride);
+}
+
+CompareKernelFn MemoryTool::GetCompareKernel(int type, int op) {
+    if (GetTypeInfo(type).size == 0) return nullptr;
+    return MemoryKernels::GetCompare((size_t)type, op);
+}
+
+// Stride of a memory scan: natural alignment, capped at 4
+static inline size_t ScanStride(int type) {
+    size_t size = MemoryTool::GetTypeInfo(type).size;
+    return size > 4 ? 4 : size;
+}
+
+size_t MemoryTool::EncodeValue(const char* value, int type, void* out) {
+    switch (type) {
+        case TYPE_DWORD: { DWORD val = atoi(value); memcpy(out, &val, sizeof(val)); return sizeof(val); }
+        case TYPE_FLOAT: { FLOAT val = strtof(value, nullptr); memcpy(out, &val, sizeof(val)); return sizeof(val); }
+        case TYPE_DOUBLE: { DOUBLE val = strtod(value, nullptr); memcpy(out, &val, sizeof(val)); return sizeof(val); }
+        case TYPE_WORD: { WORD val = (WORD)atoi(value); memcpy(out, &val, sizeof(val)); return sizeof(val); }
+        case TYPE_BYTE: { BYTE val = (BYTE)atoi(value); memcpy(out, &val, sizeof(val)); return sizeof(val); }
+        case TYPE_QWORD: { QWORD val = atoll(value); memcpy(out, &val, sizeof(val)); return sizeof(val); }
+    }
+    return 0;
+}
+
+int MemoryTool::FormatValue(const void* bytes, int type, char* out, size_t outSize) {
+    switch (type) {
+        case TYPE_DWORD: { DWORD v; memcpy(&v, bytes, sizeof(v)); return snprintf(out, outSize, "%d", v); }
+        case TYPE_FLOAT: { FLOAT v; memcpy(&v, bytes, sizeof(v)); return snprintf(out, outSize, "%f", v); }
+        case TYPE_DOUBLE: { DOUBLE v; memcpy(&v, bytes, sizeof(v)); return snprintf(out, outSize, "%lf", v); }
+        case TYPE_WORD: { WORD v; memcpy(&v, bytes, sizeof(v)); return snprintf(out, outSize, "%d", v); }
+        case TYPE_BYTE: { BYTE v; memcpy(&v, bytes, sizeof(v)); return snprintf(out, outSize, "%d", v); }
+        case TYPE_QWORD: { QWORD v; memcpy(&v, bytes, sizeof(v)); return snprintf(out, outSize, "%lld", (long long)v); }
+    }
+    return snprintf(out, outSize, "?");
+}
+
+double MemoryTool::ValueAsDouble(const void* bytes, int type) {
+    switch (type) {
+        case TYPE_DWORD: { DWORD v; memcpy(&v, bytes, sizeof(v)); return v; }
+        case TYPE_FLOAT: { FLOAT v; memcpy(&v, bytes, sizeof(v)); return v; }
+        case TYPE_DOUBLE: { DOUBLE v; memcpy(&v, bytes, sizeof(v)); return v; }
+        case TYPE_WORD: { WORD v; memcpy(&v, bytes, sizeof(v)); return v; }
+        case TYPE_BYTE: { BYTE v; memcpy(&v, bytes, sizeof(v)); return v; }
+        case TYPE_QWORD: { QWORD v; memcpy(&v, bytes, sizeof(v)); return (double)v; }
+    }
+    return 0;
+}
+
+// Typed less-than on encoded values, used to order range bounds
+static bool ValueLess(int type, uint64_t a, uint64_t b) {
+    uint32_t lt = 0;
+    ScanOperand operand;
+    operand.a = b;
+    ScanKernelFn kernel = MemoryTool::GetKernel(type, OP_LT, 1);
+    return kernel && kernel((const uint8_t*)&a, MemoryTool::GetTypeInfo(type).size, operand, &lt) == 1;
+}
+
+ScanOperand MemoryTool::MakeOperand(int op, int type, const char* a, const char* b) {
+    ScanOperand operand;
+    EncodeValue(a, type, &operand.a);
+    if (b) EncodeValue(b, type, &operand.b);
+    if (op == OP_RANGE && ValueLess(type, operand.b, operand.a)) std::swap(operand.a, operand.b);
+    return operand;
+}
+
+// Window [delta, delta] for integers; floats get a small relative tolerance so that
+// "increased by 0.1" still matches after rounding
+ScanOperand MemoryTool::MakeDeltaOperand(int type, double delta) {
+    ScanOperand operand;
+    const TypeInfo& info = GetTypeInfo(type);
+    if (info.isFloat) {
+        double eps = 1e-4 * std::max(1.0, std::fabs(delta));
+        if (type == TYPE_FLOAT) {
+            FLOAT lo = (FLOAT)(delta - eps), hi = (FLOAT)(delta + eps);
+            memcpy(&operand.a, &lo, sizeof(lo));
+            memcpy(&operand.b, &hi, sizeof(hi));
+        } else {
+            DOUBLE lo = delta - eps, hi = delta + eps;
+            memcpy(&operand.a, &lo, sizeof(lo));
+            memcpy(&operand.b, &hi, sizeof(hi));
+        }
+    } else {
+        // Two's complement in the low bytes is right for every integer width
+        int64_t d = (int64_t)llround(delta);
+        memcpy(&operand.a, &d, sizeof(d));
+        memcpy(&operand.b, &d, sizeof(d));
+    }
+    return operand;
+}
+
+// Integers must be typed as integers and fit the width, signed or unsigned. Floats match within
+// half a unit of the last digit typed ("3.14" finds 3.14159), integral input within 1e-6.
+uint8_t MemoryTool::MakeAutoOperands(const char* value, ScanOperand (&operands)[TYPE_AUTO]) {
+    char* end;
+    double d = strtod(value, &end);
+    if (end == value || !std::isfinite(d)) return 0;
+    while (isspace((unsigned char)*end)) end++;
+    if (*end) return 0;
+
+    uint8_t types = 0;
+    const char* dot = strchr(value, '.');
+    const bool integral = !dot && !strpbrk(value, "eE");
+    double eps = std::max(1e-6, std::fabs(d) * 1e-6);
+    if (dot) {
+        size_t decimals = strspn(dot + 1, "0123456789");
+        eps = std::max(eps, 0.5 * std::pow(10.0, -(double)decimals));
+    }
+    FLOAT flo = (FLOAT)(d - eps), fhi = (FLOAT)(d + eps);
+    DOUBLE dlo = d - eps, dhi = d + eps;
+    memcpy(&operands[TYPE_FLOAT].a, &flo, sizeof(flo));
+    memcpy(&operands[TYPE_FLOAT].b, &fhi, sizeof(fhi));
+    memcpy(&operands[TYPE_DOUBLE].a, &dlo, sizeof(dlo));
+    memcpy(&operands[TYPE_DOUBLE].b, &dhi, sizeof(dhi));
+    types |= (1 << TYPE_FLOAT) | (1 << TYPE_DOUBLE);
+
+    if (integral) {
+        errno = 0;
+        long long v = strtoll(value, nullptr, 10);
+        bool fits64 = errno != ERANGE;
+        if (!fits64 && *value != '-') {
+            errno = 0;
+            v = (long long)strtoull(value, nullptr, 10);
+            fits64 = errno != ERANGE;
+        }
+        const int ints[] = { TYPE_BYTE, TYPE_WORD, TYPE_DWORD, TYPE_QWORD };
+        for (int t : ints) {
+            const size_t bits = GetTypeInfo(t).size * 8;
+            bool fits = bits == 64 ? fits64 : fits64 && v >= -(1LL << (bits - 1)) && v <= (long long)((1ULL << bits) - 1);
+            if (!fits) continue;
+            operands[t].a = (uint64_t)v; // Two's complement in the low bytes
+            types |= 1 << t;
+        }
+    }
+    return types;
+}
+
+// Floats are matched by range, integers exactly
+static inline int AutoOp(int type) {
+    return MemoryTool::GetTypeInfo(type).isFloat ? OP_RANGE : OP_EQ;
+}
+
+kpm_search_query MemoryTool::MakeQuery(int op, int type, const ScanOperand& operand) {
+    const TypeInfo& info = GetTypeInfo(type);
+    kpm_search_query query;
+    query.value = operand.a;
+    query.value2 = operand.b;
+    query.val_size = info.size;
+    query.flags = 0;
+    switch (op) {
+        case OP_EQ: query.op = SEARCH_OP_EQ; break;
+        case OP_NE: query.op = SEARCH_OP_NE; break;
+        case OP_MASK: query.op = SEARCH_OP_MASK_EQ; break;
+        default: query.op = SEARCH_OP_RANGE; break;
+    }
+    // Equality and mask compares are bitwise; only ordered compares need the value's real type
+    if (query.op == SEARCH_OP_RANGE) {
+        if (info.isFloat) query.flags |= SEARCH_FLAG_FLOAT;
+        else if (info.isSigned) query.flags |= SEARCH_FLAG_SIGNED;
+    }
+    return query;
+}
+
 // ==============================================================================================
 // Search Implementations
 // ==============================================================================================
 
-// Template Search Logic for optimized bulk reading
-template <typename T>
-void MemoryTool::SearchValue(T value, const std::vector<MemoryMap>& maps, int type) {
-    m_results.clear();
-    
-    // Result buffer for Kernel to write into (Max 2048 results per chunk to be safe)
-    const int MAX_KERNEL_RES = 2048;
-    std::vector<uint64_t> kernelResBuf(MAX_KERNEL_RES); 
+// Page faults and scratch reuse over one scan. Faults are counted for the whole process, since
+// reader threads touch the buffers too.
+struct ScanFaultMeter {
+    uint64_t minor, major, acquires, reuses;
+
+    explicit ScanFaultMeter(ScanArena& arena) {
+        Read(arena, minor, major, acquires, reuses);
+    }
+
+    void Finish(ScanArena& arena, ScanStats& stats) const {
+        uint64_t minorNow, majorNow, acquiresNow, reusesNow;
+        Read(arena, minorNow, majorNow, acquiresNow, reusesNow);
+        stats.minorFaults = minorNow - minor;
+        stats.majorFaults = majorNow - major;
+        stats.scratchAcquires = acquiresNow - acquires;
+        stats.scratchReuses = reusesNow - reuses;
+        printf("Page faults: %llu minor, %llu major; scratch buffers: %llu of %llu reused\n",
+               (unsigned long long)stats.minorFaults, (unsigned long long)stats.majorFaults,
+               (unsigned long long)stats.scratchReuses, (unsigned long long)stats.scratchAcquires);
+    }
 
+    static void Read(ScanArena& arena, uint64_t& minor, uint64_t& major, uint64_t& acquires, uint64_t& reuses) {
+        struct rusage usage = {};
+        getrusage(RUSAGE_SELF, &usage);
+        minor = (uint64_t)usage.ru_minflt;
+        major = (uint64_t)usage.ru_majflt;
+        ArenaStats st = arena.Stats();
+        acquires = st.acquires;
+        reuses = st.reuses;
+    }
+};
+
+bool MemoryTool::SearchQuery(const kpm_search_query& query, const std::vector<MemoryMap>& maps, int type, ResultSink& sink) {
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t calls = kpm.syscall_count;
+    uint64_t resumptions = kpm.search_resumptions;
+    ScanFaultMeter faults(m_arena);
+    ApplyChunkSizes();
+    const size_t sliceMax = kpm.search_slice_max;
+
+    // Regions go down in windows of about SEARCH_WINDOW bytes: few round trips, but still
+    // a progress update and a cancellation point per window
+    const uint64_t SEARCH_WINDOW = 64 * 1024 * 1024;
+    std::vector<kpm_search_region> regions;
+    regions.reserve(maps.size());
+    uint64_t totalBytes = 0;
     for (const auto& map : maps) {
-        ADDRESS curr = map.startAddr;
-        while (curr < map.endAddr) {
-            // Kernel Driver handles 64KB chunks internally usually, but we can pass larger.
-            // However, to keep it responsive and update progress, use 512KB chunks.
-            size_t readSize = std::min((size_t)(map.endAddr - curr), (size_t)(512 * 1024)); 
-            
-            // Call Ring 0 Search
-            // Explicit cast to uint64_t for value to handle all types
-            uint64_t val64 = 0;
-            if (sizeof(T) == 4) val64 = (uint64_t)*(uint32_t*)&value;
-            else if (sizeof(T) == 8) val64 = *(uint64_t*)&value;
-            else if (sizeof(T) == 1) val64 = (uint64_t)*(uint8_t*)&value;
-            else if (sizeof(T) == 2) val64 = (uint64_t)*(uint16_t*)&value;
-
-            int found = kpm.search_kernel(curr, readSize, val64, sizeof(T), kernelResBuf.data(), MAX_KERNEL_RES);
-            
-            if (found > 0) {
-                for (int i = 0; i < found; i++) {
-                     m_results.push_back({kernelResBuf[i], type, map.name});
-                }
+        for (ADDRESS a = map.startAddr; a < map.endAddr; a += SEARCH_WINDOW) {
+            regions.push_back({a, std::min<ADDRESS>(map.endAddr, a + SEARCH_WINDOW)});
+        }
+        totalBytes += map.endAddr - map.startAddr;
+    }
+    BeginProgress(totalBytes);
+
+    // The result buffer is the only scratch; hits leave through the sink as they come
+    const size_t BATCH_RES = 256 * 1024;
+    ScanArena::Array<uint64_t> resBuf = m_arena.Acquire<uint64_t>(BATCH_RES);
+    size_t hits = 0;
+    size_t mapIdx = 0;
+    size_t first = 0;
+    bool more = true;
+    int searchError = 0;
+    sink.Begin(type);
+
+    while (first < regions.size() && more && !searchError && !m_progress.cancel) {
+        size_t last = first;
+        uint64_t windowBytes = 0;
+        while (last < regions.size() && (last == first || windowBytes + (regions[last].end - regions[last].start) <= SEARCH_WINDOW)) {
+            windowBytes += regions[last].end - regions[last].start;
+            last++;
+        }
+
+        // The cursor brings us back only when the result buffer fills
+        kpm_search_cursor cursor = {};
+        while (!cursor.done && more && !m_progress.cancel) {
+            size_t found = kpm.search_batch(&regions[first], (uint32_t)(last - first), query, resBuf.data(), resBuf.size(), cursor,
+                                            &searchError);
+
+            // Hits come back in region order, so the owning map only ever moves forward;
+            // each run of hits inside one map is a batch for the sink
+            size_t i = 0;
+            while (i < found && more) {
+                while (mapIdx < maps.size() && resBuf[i] >= maps[mapIdx].endAddr) mapIdx++;
+                if (mapIdx == maps.size()) break;
+                size_t j = i;
+                while (j < found && resBuf[j] < maps[mapIdx].endAddr) j++;
+                more = sink.Consume(&resBuf[i], j - i, maps[mapIdx]);
+                hits += j - i;
+                i = j;
             }
+            m_progress.hits = hits;
 
-            curr += readSize;
-            
             // Still throttle slightly if Safe Mode is on, but much less needed since no syscall spam
             if (m_safeMode) std::this_thread::sleep_for(std::chrono::milliseconds(1));
         }
+        m_progress.bytesDone += windowBytes;
+        first = last;
+    }
+
+    if (searchError) {
+        sink.End(true);
+        printf("[Error] Scan stopped, driver search failed: %s\n", strerror(searchError));
+        return false;
+    }
+    if (m_progress.cancel) {
+        sink.End(true);
+        printf("Scan cancelled\n");
+        return false;
     }
+    sink.End(false);
+
+    m_lastScan.results = hits;
+    m_lastScan.driverCalls = kpm.syscall_count - calls;
+    m_lastScan.resumptions = kpm.search_resumptions - resumptions;
+    m_lastScan.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("Found %zu results in %.1f ms (%llu driver calls, %llu overflow resumptions)\n", m_lastScan.results,
+           m_lastScan.elapsedMs, (unsigned long long)m_lastScan.driverCalls, (unsigned long long)m_lastScan.resumptions);
+    faults.Finish(m_arena, m_lastScan);
+    // Only the emulated batch search goes through slices; the driver's own batch search has none
+    if (kpm.searches_in_slices()) {
+        ObserveChunkScan("Search slice", m_tuner.slice, m_sliceOverride, sliceMax, totalBytes, m_lastScan.elapsedMs, 0, 0);
+    }
+    return true;
 }
 
-template <typename T>
-void MemoryTool::SearchRange(T from_val, T to_val, const std::vector<MemoryMap>& maps, int type) {
-    m_results.clear();
-    std::vector<uint8_t> buffer(READ_CHUNK_SIZE); 
-    
-    if (from_val > to_val) std::swap(from_val, to_val);
+static const size_t HASH_PAGE_SIZE = 4096;
+static const size_t PAGE_CACHE_MAX_HITS = 16 * 1024 * 1024; // 32 MB of offsets; denser scans are not cached
+
+// 64-bit hash of one page: four independent xxHash64-style lanes, so the multiplies of
+// neighbouring lanes overlap. 0 is reserved for "not cached".
+static uint64_t HashPage(const uint8_t* page) {
+    const uint64_t P1 = 11400714785074694791ULL, P2 = 14029467366897019727ULL;
+    auto round = [&](uint64_t acc, uint64_t x) {
+        acc += x * P2;
+        acc = (acc << 31) | (acc >> 33);
+        return acc * P1;
+    };
+    uint64_t v0 = P1 + P2, v1 = P2, v2 = 0, v3 = 0 - P1;
+    for (size_t i = 0; i < HASH_PAGE_SIZE; i += 32) {
+        uint64_t x[4];
+        memcpy(x, page + i, sizeof(x));
+        v0 = round(v0, x[0]);
+        v1 = round(v1, x[1]);
+        v2 = round(v2, x[2]);
+        v3 = round(v3, x[3]);
+    }
+    uint64_t h = ((v0 << 1) | (v0 >> 63)) + ((v1 << 7) | (v1 >> 57)) + ((v2 << 12) | (v2 >> 52)) + ((v3 << 18) | (v3 >> 46));
+    h ^= h >> 33;
+    h *= P2;
+    h ^= h >> 29;
+    return h ? h : 1;
+}
 
-    for (const auto& map : maps) {
-        ADDRESS curr = map.startAddr;
-        while (curr < map.endAddr) {
-            size_t readSize = std::min((size_t)(map.endAddr - curr), READ_CHUNK_SIZE);
-            if (readSize < sizeof(T)) break;
-
-            size_t bytesRead = kpm.read_raw(curr, buffer.data(), readSize);
-            if (bytesRead > 0) {
-                size_t alignment = sizeof(T);
-                if (alignment > 4) alignment = 4;
-
-                for (size_t i = 0; i <= bytesRead - sizeof(T); i += alignment) {
-                    T* valPtr = (T*)(buffer.data() + i);
-                    if (*valPtr >= from_val && *valPtr <= to_val) {
-                        m_results.push_back({curr + i, type, map.name});
+bool PageHashCache::Matches(int type, int op, const ScanOperand& operand, size_t chunkSize) const {
+    return this->type == type && this->op == op && a == operand.a && b == operand.b && this->chunkSize == chunkSize;
+}
+
+static void PrintPipelineStats(const PipelineStats& st) {
+    if (st.readers == 0) return;
+    printf("Pipeline: %u chunks in flight, %u readers; readers waited %llu times (%.1f ms), compare waited %llu times (%.1f ms)\n",
+           st.depth, st.readers, (unsigned long long)st.readerStalls, st.readerWaitMs,
+           (unsigned long long)st.compareStalls, st.compareWaitMs);
+}
+
+// User-side scan: copies memory in READ_CHUNK_SIZE pieces and runs the specialized kernel on each
+bool MemoryTool::SearchUser(int op, const ScanOperand& operand, const std::vector<MemoryMap>& maps, int type, ResultSink& sink) {
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t calls = kpm.syscall_count;
+    ScanFaultMeter faults(m_arena);
+    const size_t size = GetTypeInfo(type).size;
+    const size_t stride = ScanStride(type);
+    ScanKernelFn kernel = GetKernel(type, op, stride);
+    if (!kernel) {
+        printf("Unknown Type\n");
+        return false;
+    }
+    const bool pageHashSkip = m_pageHashSkip; // Settings can change mid-scan; use one value throughout
+    ApplyChunkSizes();
+    // A rescan keeps the chunking its cached page hits belong to rather than probing another size
+    if (pageHashSkip && !m_chunkOverride && m_pageCache.Matches(type, op, operand, m_pageCache.chunkSize) &&
+        ChunkTuner::IndexOf(m_pageCache.chunkSize) >= 0) {
+        READ_CHUNK_SIZE = m_pageCache.chunkSize;
+    }
+
+    ScanArena::Array<uint32_t> offsets = m_arena.Acquire<uint32_t>(READ_CHUNK_SIZE / stride + 1);
+    ScanArena::Array<ADDRESS> batch = m_arena.Acquire<ADDRESS>(READ_CHUNK_SIZE / stride + 1);
+    size_t hits = 0;
+    bool more = true;
+    sink.Begin(type);
+
+    // Hits are cached per page, so chunks are scanned a page at a time; an element that
+    // straddles into the next page is only reused when that page is unchanged too
+    const bool useCache = pageHashSkip && READ_CHUNK_SIZE % HASH_PAGE_SIZE == 0;
+    const bool prevValid = useCache && m_pageCache.Matches(type, op, operand, READ_CHUNK_SIZE);
+    PageHashCache next;
+    next.type = type;
+    next.op = op;
+    next.a = operand.a;
+    next.b = operand.b;
+    next.chunkSize = READ_CHUNK_SIZE;
+    size_t cachedHits = 0;
+    ScanArena::Array<uint64_t> pageHashes = m_arena.Acquire<uint64_t>(READ_CHUNK_SIZE / HASH_PAGE_SIZE);
+    ScanArena::Array<uint32_t> pageHits = m_arena.Acquire<uint32_t>(HASH_PAGE_SIZE / stride + 1);
+    uint64_t pagesReused = 0, pagesTotal = 0;
+
+    uint64_t totalBytes = 0;
+    for (const auto& map : maps) totalBytes += map.endAddr - map.startAddr;
+    BeginProgress(totalBytes);
+
+    // Reads run ahead on reader threads while this thread compares
+    ChunkReader reader(kpm, m_arena, maps, READ_CHUNK_SIZE, m_readAhead, m_readerThreads);
+    const MemoryMap* map = nullptr;
+    const PageHashCache::Range* prev = nullptr;
+    PageHashCache::Range* range = nullptr;
+    auto finishRange = [&]() {
+        if (range) {
+            while (range->hitStart.size() <= range->hashes.size()) range->hitStart.push_back((uint32_t)range->hits.size());
+        }
+    };
+
+    while (more) {
+        if (m_progress.cancel) {
+            sink.End(true);
+            printf("Scan cancelled\n");
+            return false;
+        }
+        const ChunkReader::Chunk* chunk = reader.Next();
+        if (!chunk) break;
+        if (chunk->map != map) {
+            finishRange();
+            map = chunk->map;
+            prev = nullptr;
+            if (prevValid) {
+                auto it = m_pageCache.ranges.find(map->startAddr);
+                if (it != m_pageCache.ranges.end()) prev = &it->second;
+            }
+            range = nullptr;
+            if (useCache && cachedHits <= PAGE_CACHE_MAX_HITS) {
+                range = &next.ranges[map->startAddr];
+                range->hashes.assign((map->endAddr - map->startAddr) / HASH_PAGE_SIZE, 0);
+                range->hitStart.reserve(range->hashes.size() + 1);
+            }
+        }
+        const ADDRESS curr = chunk->addr;
+        const size_t readSize = chunk->size;
+        const size_t bytesRead = chunk->bytesRead;
+        const uint8_t* buffer = chunk->data;
+
+        size_t n = 0;
+        if (readSize < size) {
+            // Tail of a map too short for one value
+        } else if (!range) {
+            n = kernel(buffer, bytesRead, operand, offsets.data());
+        } else {
+            const size_t firstPage = (curr - map->startAddr) / HASH_PAGE_SIZE;
+            const size_t fullPages = bytesRead / HASH_PAGE_SIZE;
+            for (size_t p = 0; p < fullPages; p++) pageHashes[p] = HashPage(&buffer[p * HASH_PAGE_SIZE]);
+            auto unchanged = [&](size_t p) {
+                return p < fullPages && prev && firstPage + p < prev->hashes.size() &&
+                       prev->hashes[firstPage + p] == pageHashes[p];
+            };
+
+            for (size_t pageOff = 0; pageOff + size <= bytesRead; pageOff += HASH_PAGE_SIZE) {
+                const size_t p = pageOff / HASH_PAGE_SIZE;
+                const bool lastOfChunk = pageOff + HASH_PAGE_SIZE == readSize && bytesRead == readSize;
+                size_t count;
+                if (unchanged(p) && (stride >= size || lastOfChunk || unchanged(p + 1))) {
+                    const size_t from = prev->hitStart[firstPage + p];
+                    count = prev->hitStart[firstPage + p + 1] - from;
+                    for (size_t i = 0; i < count; i++) pageHits[i] = prev->hits[from + i];
+                    pagesReused++;
+                } else {
+                    // Elements starting in this page, including ones that run into the next
+                    count = kernel(&buffer[pageOff], std::min(HASH_PAGE_SIZE + size - 1, bytesRead - pageOff), operand, pageHits.data());
+                }
+                pagesTotal++;
+                for (size_t i = 0; i < count; i++) offsets[n + i] = (uint32_t)(pageOff + pageHits[i]);
+                n += count;
+
+                if (firstPage + p < range->hashes.size()) {
+                    while (range->hitStart.size() <= firstPage + p) range->hitStart.push_back((uint32_t)range->hits.size());
+                    if (p < fullPages) {
+                        range->hashes[firstPage + p] = pageHashes[p];
+                        for (size_t i = 0; i < count; i++) range->hits.push_back((uint16_t)pageHits[i]);
+                        cachedHits += count;
                     }
                 }
             }
-             curr += readSize;
+        }
+        for (size_t i = 0; i < n; i++) batch[i] = curr + offsets[i];
+        if (n) more = sink.Consume(batch.data(), n, *map);
+        hits += n;
+        m_progress.bytesDone += readSize;
+        m_progress.hits = hits;
 
-            if (m_safeMode) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (m_safeMode) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    finishRange();
+    sink.End(false);
+
+    // Only a complete scan describes every page; an early stop keeps the previous cache
+    if (useCache && more) {
+        if (cachedHits <= PAGE_CACHE_MAX_HITS) m_pageCache = std::move(next);
+        else m_pageCache = PageHashCache();
+    }
+
+    m_lastScan.results = hits;
+    m_lastScan.driverCalls = kpm.syscall_count - calls;
+    m_lastScan.resumptions = 0;
+    m_lastScan.pagesReused = pagesReused;
+    m_lastScan.pagesTotal = pagesTotal;
+    m_lastScan.pipeline = reader.Stats();
+    m_lastScan.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("Found %zu results in %.1f ms (%llu reads, %llu of %llu pages unchanged)\n", m_lastScan.results, m_lastScan.elapsedMs,
+           (unsigned long long)m_lastScan.driverCalls, (unsigned long long)pagesReused, (unsigned long long)pagesTotal);
+    PrintPipelineStats(m_lastScan.pipeline);
+    faults.Finish(m_arena, m_lastScan);
+    ObserveChunkScan("Read chunk", m_tuner.read, m_chunkOverride, READ_CHUNK_SIZE, totalBytes, m_lastScan.elapsedMs,
+                     m_lastScan.pipeline.chunks, m_lastScan.pipeline.shortReads);
+    return true;
+}
+
+// AUTO scan: every lane runs over the same block while it is still in cache, then the lanes'
+// offset lists are merged into one row per address with the mask of the types that matched.
+// Integer types share one lane: any integer match starts with the value's low byte, so memchr
+// (vectorized in libc, several times faster than a stride-1 kernel) finds the candidates and
+// each integer width is checked only there.
+bool MemoryTool::SearchAuto(const char* value, const std::vector<MemoryMap>& maps, ResultSink& sink) {
+    auto startTime = std::chrono::steady_clock::now();
+    uint64_t calls = kpm.syscall_count;
+    ScanFaultMeter faults(m_arena);
+    ScanOperand operands[TYPE_AUTO];
+    uint8_t types = MakeAutoOperands(value, operands);
+    if (!types) {
+        printf("[Error] AUTO needs a number\n");
+        return false;
+    }
+
+    const size_t AUTO_BLOCK = 16 * 1024;
+    const uint8_t INT_TYPES = (1 << TYPE_BYTE) | (1 << TYPE_WORD) | (1 << TYPE_DWORD) | (1 << TYPE_QWORD);
+    struct Lane {
+        int type;     // TYPE_AUTO for the integer lane
+        size_t size;  // Bytes past an element start the lane may read
+        ScanKernelFn kernel;
+        ScanArena::Array<uint32_t> hits;
+        ScanArena::Array<uint8_t> masks; // Integer lane only; other lanes match as 1 << type
+        size_t count, pos;
+    };
+    std::vector<Lane> lanes;
+    if (types & INT_TYPES) {
+        Lane lane = { TYPE_AUTO, 8, nullptr, {}, {}, 0, 0 };
+        lane.hits = m_arena.Acquire<uint32_t>(AUTO_BLOCK + 8);
+        lane.masks = m_arena.Acquire<uint8_t>(AUTO_BLOCK + 8);
+        lanes.push_back(std::move(lane));
+    }
+    for (int t = 0; t < TYPE_AUTO; t++) {
+        if (!(types & (1 << t)) || (INT_TYPES & (1 << t))) continue;
+        Lane lane = { t, GetTypeInfo(t).size, GetKernel(t, AutoOp(t), ScanStride(t)), {}, {}, 0, 0 };
+        lane.hits = m_arena.Acquire<uint32_t>(AUTO_BLOCK / ScanStride(t) + 1);
+        lanes.push_back(std::move(lane));
+    }
+    // Any operand of an integer type holds the low byte
+    int lowByte = 0;
+    for (int t = 0; t < TYPE_AUTO; t++) {
+        if (types & INT_TYPES & (1 << t)) lowByte = (int)(operands[t].a & 0xFF);
+    }
+
+    ApplyChunkSizes();
+    ScanArena::Array<uint32_t> offsets = m_arena.Acquire<uint32_t>(READ_CHUNK_SIZE + 1);
+    ScanArena::Array<uint8_t> masks = m_arena.Acquire<uint8_t>(READ_CHUNK_SIZE + 1);
+    ScanArena::Array<ADDRESS> batch = m_arena.Acquire<ADDRESS>(READ_CHUNK_SIZE + 1);
+    size_t hits = 0;
+    bool more = true;
+    sink.Begin(TYPE_AUTO);
+
+    uint64_t totalBytes = 0;
+    for (const auto& map : maps) totalBytes += map.endAddr - map.startAddr;
+    BeginProgress(totalBytes);
+
+    ChunkReader reader(kpm, m_arena, maps, READ_CHUNK_SIZE, m_readAhead, m_readerThreads);
+    while (more) {
+        if (m_progress.cancel) {
+            sink.End(true);
+            printf("Scan cancelled\n");
+            return false;
+        }
+        const ChunkReader::Chunk* chunk = reader.Next();
+        if (!chunk) break;
+        const ADDRESS curr = chunk->addr;
+        const size_t bytesRead = chunk->bytesRead;
+        const uint8_t* buffer = chunk->data;
+
+        size_t n = 0;
+        for (size_t blockOff = 0; blockOff < bytesRead; blockOff += AUTO_BLOCK) {
+            // Elements starting in this block, including ones that run into the next
+            const size_t blockLen = std::min(AUTO_BLOCK, bytesRead - blockOff);
+            for (auto& lane : lanes) {
+                lane.pos = 0;
+                if (lane.type != TYPE_AUTO) {
+                    size_t len = std::min(AUTO_BLOCK + lane.size - 1, bytesRead - blockOff);
+                    lane.count = len >= lane.size ? lane.kernel(&buffer[blockOff], len, operands[lane.type], lane.hits.data()) : 0;
+                    continue;
+                }
+                lane.count = 0;
+                const uint8_t* block = &buffer[blockOff];
+                for (const uint8_t* p = block; (p = (const uint8_t*)memchr(p, lowByte, block + blockLen - p)) != nullptr; p++) {
+                    const uint32_t off = (uint32_t)(p - block);
+                    uint8_t mask = 0;
+                    for (uint32_t m = types & INT_TYPES; m; m &= m - 1) {
+                        const int t = __builtin_ctz(m);
+                        const size_t size = GetTypeInfo(t).size;
+                        if (off % ScanStride(t) == 0 && blockOff + off + size <= bytesRead &&
+                            memcmp(&buffer[blockOff + off], &operands[t].a, size) == 0) {
+                            mask |= 1 << t;
+                        }
+                    }
+                    if (!mask) continue;
+                    lane.hits[lane.count] = off;
+                    lane.masks[lane.count++] = mask;
+                }
+            }
+            // Each lane is ascending, so the smallest head is the next address
+            for (;;) {
+                uint32_t next = UINT32_MAX;
+                for (const auto& lane : lanes) {
+                    if (lane.pos < lane.count && lane.hits[lane.pos] < next) next = lane.hits[lane.pos];
+                }
+                if (next == UINT32_MAX) break;
+                uint8_t mask = 0;
+                for (auto& lane : lanes) {
+                    if (lane.pos < lane.count && lane.hits[lane.pos] == next) {
+                        mask |= lane.type == TYPE_AUTO ? lane.masks[lane.pos] : 1 << lane.type;
+                        lane.pos++;
+                    }
+                }
+                offsets[n] = (uint32_t)(blockOff + next);
+                masks[n++] = mask;
+            }
         }
+        for (size_t i = 0; i < n; i++) batch[i] = curr + offsets[i];
+        if (n) more = sink.ConsumeTyped(batch.data(), masks.data(), n, *chunk->map);
+        hits += n;
+        m_progress.bytesDone += chunk->size;
+        m_progress.hits = hits;
+
+        if (m_safeMode) std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+    sink.End(false);
+
+    m_lastScan.results = hits;
+    m_lastScan.driverCalls = kpm.syscall_count - calls;
+    m_lastScan.resumptions = 0;
+    m_lastScan.pagesReused = 0;
+    m_lastScan.pagesTotal = 0;
+    m_lastScan.pipeline = reader.Stats();
+    m_lastScan.elapsedMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("Found %zu results in %.1f ms (%llu reads, %d types)\n", m_lastScan.results, m_lastScan.elapsedMs,
+           (unsigned long long)m_lastScan.driverCalls, __builtin_popcount(types));
+    PrintPipelineStats(m_lastScan.pipeline);
+    faults.Finish(m_arena, m_lastScan);
+    ObserveChunkScan("Read chunk", m_tuner.read, m_chunkOverride, READ_CHUNK_SIZE, totalBytes, m_lastScan.elapsedMs,
+                     m_lastScan.pipeline.chunks, m_lastScan.pipeline.shortReads);
+    return true;
 }
 
 void MemoryTool::MemorySearch(const char* value, int type) {
-    auto maps = readmaps(m_searchRange);
-    printf("Scanning %zu memory regions...\n", maps.size());
-
-    switch (type) {
-        case TYPE_DWORD: SearchValue<DWORD>(atoi(value), maps, type); break;
-        case TYPE_FLOAT: SearchValue<FLOAT>(strtof(value, nullptr), maps, type); break;
-        case TYPE_DOUBLE: SearchValue<DOUBLE>(strtod(value, nullptr), maps, type); break;
-        case TYPE_WORD: SearchValue<WORD>((WORD)atoi(value), maps, type); break;
-        case TYPE_BYTE: SearchValue<BYTE>((BYTE)atoi(value), maps, type); break;
-        case TYPE_QWORD: SearchValue<QWORD>(atoll(value), maps, type); break;
-        default: printf("Unknown Type\n"); break;
+    StoreSink sink;
+    PrepareStoreSink(sink);
+    if (!MemorySearch(value, type, sink)) return;
+    if (sink.Spilled()) {
+        printf("Results spilled to disk to stay within the memory budget; values not captured\n");
+    } else if (m_captureValues && type != TYPE_AUTO) {
+        // Every hit of an equality scan holds the searched value, no need to read it back
+        uint8_t bytes[8];
+        size_t width = EncodeValue(value, type, bytes);
+        std::vector<uint8_t> packed(sink.store.Size() * width);
+        for (size_t i = 0; i < sink.store.Size(); i++) memcpy(&packed[i * width], bytes, width);
+        sink.store.SetValues(std::move(packed), (uint32_t)width);
     }
+    CommitResults(std::move(sink.store));
 }
 
 void MemoryTool::RangeMemorySearch(const char* from_value, const char* to_value, int type) {
+    StoreSink sink;
+    PrepareStoreSink(sink);
+    if (!RangeMemorySearch(from_value, to_value, type, sink)) return;
+    if (sink.Spilled()) printf("Results spilled to disk to stay within the memory budget; values not captured\n");
+    else if (m_captureValues) CaptureValues(sink.store);
+    CommitResults(std::move(sink.store));
+}
+
+bool MemoryTool::MemorySearch(const char* value, int type, ResultSink& sink) {
+    if (type == TYPE_AUTO) {
+        // No driver op covers several types at once: read everything once and compare here
+        auto maps = readmaps(m_searchRange);
+        printf("Scanning %zu memory regions (AUTO)...\n", maps.size());
+        return SearchAuto(value, maps, sink);
+    }
+    if (GetTypeInfo(type).size == 0) {
+        printf("Unknown Type\n");
+        return false;
+    }
     auto maps = readmaps(m_searchRange);
-    printf("Scanning %zu memory regions (Range)...\n", maps.size());
+    printf("Scanning %zu memory regions...\n", maps.size());
+    return SearchQuery(MakeQuery(OP_EQ, type, MakeOperand(OP_EQ, type, value, nullptr)), maps, type, sink);
+}
 
-     switch (type) {
-        case TYPE_DWORD: SearchRange<DWORD>(atoi(from_value), atoi(to_value), maps, type); break;
-        case TYPE_FLOAT: SearchRange<FLOAT>(strtof(from_value, nullptr), strtof(to_value, nullptr), maps, type); break;
-        case TYPE_DOUBLE: SearchRange<DOUBLE>(strtod(from_value, nullptr), strtod(to_value, nullptr), maps, type); break;
-        case TYPE_WORD: SearchRange<WORD>((WORD)atoi(from_value), (WORD)atoi(to_value), maps, type); break;
-        case TYPE_BYTE: SearchRange<BYTE>((BYTE)atoi(from_value), (BYTE)atoi(to_value), maps, type); break;
-        case TYPE_QWORD: SearchRange<QWORD>(atoll(from_value), atoll(to_value), maps, type); break;
-        default: printf("Unknown Type\n"); break;
+bool MemoryTool::RangeMemorySearch(const char* from_value, const char* to_value, int type, ResultSink& sink) {
+    if (GetTypeInfo(type).size == 0) {
+        printf("Unknown Type\n");
+        return false;
     }
+    auto maps = readmaps(m_searchRange);
+    ScanOperand operand = MakeOperand(OP_RANGE, type, from_value, to_value);
+
+    // In-place range scan on drivers that have CMD_SEARCH_EX, otherwise copy everything and compare here
+    if (kpm.supports_search_ops()) {
+        printf("Scanning %zu memory regions (Range, driver-side)...\n", maps.size());
+        return SearchQuery(MakeQuery(OP_RANGE, type, operand), maps, type, sink);
+    }
+
+    printf("Scanning %zu memory regions (Range)...\n", maps.size());
+    return SearchUser(OP_RANGE, operand, maps, type, sink);
 }
 
 // ==============================================================================================
 // Offset / Refine
 // ==============================================================================================
 
-void MemoryTool::MemoryOffset(const char* value, long int offset, int type) {
-    if (m_results.empty()) {
-        printf("No results to refine.\n");
-        return;
+// One refine pass: reads the value at +offset of every result with coalesced span reads,
+// gathers them into a dense array and lets 'filter' pick the rows to keep. When the field is
+// the result itself, the values just read become the new value column.
+// TYPE_AUTO gathers 8-byte slots (zero-padded past the widest type a row may be) and the filter
+// also writes the kept rows' new type masks.
+template <typename Filter>
+void MemoryTool::RefineSpans(const char* label, long int offset, int type, Filter filter) {
+    const bool autoType = type == TYPE_AUTO;
+    const size_t width = autoType ? 8 : GetTypeInfo(type).size;
+
+    // Spans need ascending addresses; scans produce them that way, but results may come from
+    // elsewhere. Sorting reorders rows, so it starts a new history.
+    if (!m_results.IsSorted()) {
+        ResultStore sorted = m_results;
+        sorted.Sort();
+        CommitResults(std::move(sorted));
     }
 
-    std::vector<MemoryResult> newResults;
-    newResults.reserve(m_results.size()); // Expect reduction, but reserve to avoid reallocs
-
-    // For refinement, we usually check singular addresses, so bulk read is harder per result.
-    // However, if results are clustered, we could bulk read.
-    // For simplicity and correctness with sparse results, we read individual values.
-    // Optimization: If performance is issue, sort results and batch read.
-
-    for (const auto& res : m_results) {
-        ADDRESS targetAddr = res.addr + offset;
-        bool match = false;
-        
-        switch (type) {
-            case TYPE_DWORD: {
-                DWORD val = 0;
-                if (kpm.read_raw(targetAddr, &val, sizeof(val)) == sizeof(val)) {
-                    if (val == atoi(value)) match = true;
-                }
-                break;
+    const ADDRESS* addrs = m_results.Addrs();
+    auto rowWidth = [&](size_t i) {
+        if (!autoType || !m_results.HasTypeMasks()) return width;
+        size_t w = 0;
+        for (uint32_t m = m_results.TypeMask(i); m; m &= m - 1) w = std::max<size_t>(w, GetTypeInfo(__builtin_ctz(m)).size);
+        return w;
+    };
+    std::vector<ReadSpan> spans = BuildReadSpans(m_results.Size(),
+        [&](size_t i) { return addrs[i] + offset; },
+        rowWidth);
+
+    ResultStore newResults;
+    newResults.type = m_results.type; // Refining at an offset or as another type keeps the scanned type
+    if (autoType || (m_results.HasTypeMasks() && offset == 0)) newResults.type = type; // Except AUTO rows, which narrow
+    if (newResults.type == TYPE_AUTO) newResults.EnableTypeMasks();
+    std::vector<uint64_t> removed((m_results.Size() + 63) / 64, ~0ULL); // History delta, kept rows cleared below
+    bool keepValues = m_captureValues && offset == 0 && type == newResults.type && !autoType;
+    if (keepValues) newResults.EnableValues((uint32_t)width);
+    BeginProgress(m_results.Size());
+
+    std::vector<uint8_t> spanBuf(SPAN_MAX_LEN);
+    std::vector<uint8_t> values;
+    std::vector<uint8_t> kept;
+    std::vector<uint32_t> hits;
+    std::vector<uint8_t> masks;
+    std::vector<uint8_t> unread;
+    static const ADDRESS pageMask = ~(ADDRESS)(sysconf(_SC_PAGESIZE) - 1);
+    for (const auto& span : spans) {
+        if (m_progress.cancel) {
+            printf("Refine cancelled, previous results kept\n");
+            return;
+        }
+        // A short read (the span runs into a page that went away) keeps the rows it covered;
+        // the rest are read one by one, skipping pages already found unreadable, and only rows
+        // that cannot be read at all are dropped
+        size_t got = kpm.read_raw(span.addr, spanBuf.data(), span.len);
+        values.resize((size_t)span.count * width);
+        hits.resize(span.count + 1);
+        masks.resize(span.count + 1);
+        unread.assign(span.count, 0);
+        uint32_t unreadCount = 0;
+        ADDRESS badPage = got < span.len ? (span.addr + got) & pageMask : 0; // Where the span read stopped
+        for (uint32_t i = 0; i < span.count; i++) {
+            size_t w = autoType ? rowWidth(span.first + i) : width;
+            size_t pos = addrs[span.first + i] + offset - span.addr;
+            if (w < width) memset(&values[i * width], 0, width);
+            if (pos + w <= got) {
+                memcpy(&values[i * width], &spanBuf[pos], w);
+                continue;
             }
-            case TYPE_FLOAT: {
-                FLOAT val = 0;
-                if (kpm.read_raw(targetAddr, &val, sizeof(val)) == sizeof(val)) {
-                    // Float comparison needs epsilon? For equality search usually exact match or very close.
-                    // Implementation uses exact match for now as per original.
-                     if (val == strtof(value, nullptr)) match = true;
-                }
-                break;
+            ADDRESS addr = span.addr + pos;
+            if ((addr & pageMask) == badPage || kpm.read_raw(addr, &values[i * width], w) != w) {
+                badPage = addr & pageMask;
+                unread[i] = 1; // The filter still sees the row (zeroed) so runs stay contiguous
+                unreadCount++;
             }
-             case TYPE_DOUBLE: {
-                DOUBLE val = 0;
-                if (kpm.read_raw(targetAddr, &val, sizeof(val)) == sizeof(val)) {
-                     if (val == strtod(value, nullptr)) match = true;
+        }
+        if (unreadCount < span.count) {
+            size_t n = filter(values.data(), span.first, span.count, hits.data(), masks.data());
+            if (unreadCount) {
+                size_t k = 0;
+                for (size_t h = 0; h < n; h++) {
+                    if (unread[hits[h]]) continue;
+                    masks[k] = masks[h];
+                    hits[k++] = hits[h];
                 }
-                break;
-            }
-            // ... implement others similarly
-            case TYPE_WORD: {
-                WORD val = 0;
-                if (kpm.read_raw(targetAddr, &val, sizeof(val)) == sizeof(val)) match = (val == atoi(value));
-                break;
+                n = k;
             }
-             case TYPE_BYTE: {
-                BYTE val = 0;
-                if (kpm.read_raw(targetAddr, &val, sizeof(val)) == sizeof(val)) match = (val == atoi(value));
-                break;
+            if (keepValues) {
+                kept.resize(n * width);
+                for (size_t h = 0; h < n; h++) memcpy(&kept[h * width], &values[hits[h] * width], width);
+                newResults.AppendValues(kept.data(), n);
             }
-             case TYPE_QWORD: {
-                QWORD val = 0;
-                if (kpm.read_raw(targetAddr, &val, sizeof(val)) == sizeof(val)) match = (val == atoll(value));
-                break;
+            // Keep original address: Offset/Refine filters the ORIGINAL list based on condition at offset
+            for (size_t h = 0; h < n; h++) {
+                hits[h] += span.first;
+                removed[hits[h] / 64] &= ~(1ULL << (hits[h] % 64));
             }
+            newResults.AppendRows(m_results, hits.data(), n, autoType ? masks.data() : nullptr);
         }
+        m_progress.bytesDone += span.count;
+        m_progress.hits = newResults.Size();
+    }
+    CommitRefine(std::move(newResults), std::move(removed), label);
+}
+
+// Keeps the results whose value at +offset satisfies the operator
+void MemoryTool::RefineResults(int op, const ScanOperand& operand, long int offset, int type) {
+    if (m_results.Empty()) {
+        printf("No results to refine.\n");
+        return;
+    }
+    const size_t width = GetTypeInfo(type).size;
+    ScanKernelFn kernel = GetKernel(type, op, width);
+    if (!kernel) {
+        printf("Unknown Type\n");
+        return;
+    }
+    RefineSpans("Refine", offset, type, [&](const uint8_t* values, uint32_t /*first*/, uint32_t count, uint32_t* hits, uint8_t*) {
+        size_t n = kernel(values, count * width, operand, hits);
+        for (size_t h = 0; h < n; h++) hits[h] /= width; // Byte offsets to row indices
+        return n;
+    });
+}
+
+// Keeps the results whose current value relates to the captured one as asked
+void MemoryTool::CompareResults(int op, const ScanOperand& operand) {
+    if (m_results.Empty()) {
+        printf("No results to refine.\n");
+        return;
+    }
+    if (m_results.HasTypeMasks()) {
+        printf("AUTO results have no single type; refine them by value or as one type first.\n");
+        return;
+    }
+    if (!m_results.HasValues()) {
+        printf("Results carry no previous values; scan again with value capture on.\n");
+        return;
+    }
+    const int type = m_results.type;
+    CompareKernelFn kernel = GetCompareKernel(type, op);
+    if (!kernel) {
+        printf("Unknown Type\n");
+        return;
+    }
+    // Captured values are aligned with m_results, which RefineSpans sorts first; sorting moves them too
+    RefineSpans("Compare", 0, type, [&](const uint8_t* values, uint32_t first, uint32_t count, uint32_t* hits, uint8_t*) {
+        return kernel(values, m_results.Value(first), count, operand, hits);
+    });
+}
+
+// Keeps the results whose value still matches as at least one of their types, and narrows
+// each row's type mask to the types that did
+void MemoryTool::RefineAuto(const char* value) {
+    if (m_results.Empty()) {
+        printf("No results to refine.\n");
+        return;
+    }
+    ScanOperand operands[TYPE_AUTO];
+    uint8_t types = MakeAutoOperands(value, operands);
+    if (!types) {
+        printf("[Error] AUTO needs a number\n");
+        return;
+    }
+    std::vector<uint32_t> typeHits;
+    std::vector<uint8_t> rowMasks;
+    RefineSpans("Refine", 0, TYPE_AUTO, [&](const uint8_t* values, uint32_t first, uint32_t count, uint32_t* hits, uint8_t* masks) {
+        // Every type reads the low bytes of each 8-byte slot
+        typeHits.resize(count + 1);
+        rowMasks.assign(count, 0);
+        for (int t = 0; t < TYPE_AUTO; t++) {
+            if (!(types & (1 << t))) continue;
+            size_t n = GetKernel(t, AutoOp(t), 8)(values, (size_t)count * 8, operands[t], typeHits.data());
+            for (size_t h = 0; h < n; h++) rowMasks[typeHits[h] / 8] |= 1 << t;
+        }
+        size_t n = 0;
+        for (uint32_t i = 0; i < count; i++) {
+            uint8_t mask = rowMasks[i] & (m_results.HasTypeMasks() ? m_results.TypeMask(first + i) : types);
+            if (!mask) continue;
+            hits[n] = i;
+            masks[n++] = mask;
+        }
+        return n;
+    });
+}
+
+void MemoryTool::MemoryOffset(const char* value, long int offset, int type) {
+    if (type == TYPE_AUTO) {
+        if (offset != 0) printf("[Error] AUTO refines the results themselves, not an offset\n");
+        else RefineAuto(value);
+        return;
+    }
+    RefineResults(OP_EQ, MakeOperand(OP_EQ, type, value, nullptr), offset, type);
+}
+
+void MemoryTool::RangeMemoryOffset(const char* from_value, const char* to_value, long int offset, int type) {
+    RefineResults(OP_RANGE, MakeOperand(OP_RANGE, type, from_value, to_value), offset, type);
+}
+
+void MemoryTool::MemoryCompare(int mode, const char* by) {
+    const int type = m_results.type;
+    switch (mode) {
+        case COMPARE_CHANGED: CompareResults(CMP_NE, ScanOperand()); break;
+        case COMPARE_UNCHANGED: CompareResults(CMP_EQ, ScanOperand()); break;
+        case COMPARE_INCREASED: CompareResults(CMP_GT, ScanOperand()); break;
+        case COMPARE_DECREASED: CompareResults(CMP_LT, ScanOperand()); break;
+        case COMPARE_INCREASED_BY: CompareResults(CMP_DELTA, MakeDeltaOperand(type, strtod(by, nullptr))); break;
+        case COMPARE_DECREASED_BY: CompareResults(CMP_DELTA, MakeDeltaOperand(type, -strtod(by, nullptr))); break;
+    }
+}
 
-        if (match) {
-            // Keep original address or update to new offset address? 
-            // Usually Offset/Refine filters the ORIGINAL list based on condition at offset.
-            // Original code: pNew->addr = pTemp->addr; (Keeps original address)
-            newResults.push_back(res);
+// Values of every result at its own address, packed at the store's width
+void MemoryTool::CaptureValues(ResultStore& store) {
+    const size_t width = GetTypeInfo(store.type).size;
+    const ADDRESS* addrs = store.Addrs();
+    std::vector<ReadSpan> spans = BuildReadSpans(store.Size(),
+        [&](size_t i) { return addrs[i]; },
+        [&](size_t) { return width; });
+
+    std::vector<uint8_t> packed(store.Size() * width); // Unreadable rows stay zero
+    std::vector<uint8_t> spanBuf(SPAN_MAX_LEN);
+    for (const auto& span : spans) {
+        if (kpm.read_raw(span.addr, spanBuf.data(), span.len) != span.len) continue;
+        for (uint32_t i = 0; i < span.count; i++) {
+            memcpy(&packed[(size_t)(span.first + i) * width], &spanBuf[addrs[span.first + i] - span.addr], width);
         }
     }
-    m_results = std::move(newResults);
+    store.SetValues(std::move(packed), (uint32_t)width);
 }
 
 void MemoryTool::MemoryWrite(const char* value, long int offset, int type) {
-    for (const auto& res : m_results) {
-        ADDRESS targetAddr = res.addr + offset;
-        WriteAddress(targetAddr, value, type);
+    uint8_t bytes[8];
+    size_t size = EncodeValue(value, type, bytes);
+    if (size == 0) return;
+    BeginProgress(m_results.Size());
+    for (size_t i = 0; i < m_results.Size(); i++) {
+        if (m_progress.cancel) break;
+        kpm.write_raw(m_results.Addr(i) + offset, bytes, size);
+        m_progress.bytesDone++;
     }
 }
 
 int MemoryTool::WriteAddress(ADDRESS addr, const char* value, int type) {
-    switch (type) {
-        case TYPE_DWORD: { DWORD val = atoi(value); return kpm.write(addr, val); }
-        case TYPE_FLOAT: { FLOAT val = strtof(value, nullptr); return kpm.write(addr, val); }
-        case TYPE_DOUBLE: { DOUBLE val = strtod(value, nullptr); return kpm.write(addr, val); }
-        case TYPE_WORD: { WORD val = (WORD)atoi(value); return kpm.write(addr, val); }
-        case TYPE_BYTE: { BYTE val = (BYTE)atoi(value); return kpm.write(addr, val); }
-        case TYPE_QWORD: { QWORD val = atoll(value); return kpm.write(addr, val); }
-    }
-    return 0;
+    uint8_t bytes[8];
+    size_t size = EncodeValue(value, type, bytes);
+    return size && kpm.write_raw(addr, bytes, size) == size;
 }
 
 // ==============================================================================================
@@ -383,39 +1176,26 @@ int MemoryTool::WriteAddress(ADDRESS addr, const char* value, int type) {
 // ==============================================================================================
 
 std::string MemoryTool::GetAddressValue(ADDRESS addr, int type) {
+    const TypeInfo& info = GetTypeInfo(type);
+    if (info.size == 0) return "?";
+    uint64_t bits = 0;
+    kpm.read_raw(addr, &bits, info.size);
     char buffer[64];
-    switch (type) {
-        case TYPE_DWORD: snprintf(buffer, 64, "%d", kpm.read<DWORD>(addr)); break;
-        case TYPE_FLOAT: snprintf(buffer, 64, "%f", kpm.read<FLOAT>(addr)); break;
-        case TYPE_DOUBLE: snprintf(buffer, 64, "%lf", kpm.read<DOUBLE>(addr)); break;
-        case TYPE_WORD: snprintf(buffer, 64, "%d", kpm.read<WORD>(addr)); break;
-        case TYPE_BYTE: snprintf(buffer, 64, "%d", kpm.read<BYTE>(addr)); break;
-        case TYPE_QWORD: snprintf(buffer, 64, "%lld", kpm.read<QWORD>(addr)); break;
-        default: return "?";
-    }
+    FormatValue(&bits, type, buffer, sizeof(buffer));
     return std::string(buffer);
 }
 
-void MemoryTool::PrintResults() {
-    int count = 0;
-    for (const auto& res : m_results) {
-        std::string valStr = GetAddressValue(res.addr, res.type);
-        const char* typeStr = "UNKNOWN";
-        switch(res.type) {
-            case TYPE_DWORD: typeStr = "DWORD"; break;
-            case TYPE_FLOAT: typeStr = "FLOAT"; break;
-            case TYPE_DOUBLE: typeStr = "DOUBLE"; break;
-            case TYPE_WORD: typeStr = "WORD"; break;
-            case TYPE_BYTE: typeStr = "BYTE"; break;
-            case TYPE_QWORD: typeStr = "QWORD"; break;
-        }
+// Prints rows [first, first + count); page through large sets by moving 'first'
+void MemoryTool::PrintResults(size_t first, size_t count) {
+    size_t end = std::min(m_results.Size(), first + count);
+    for (size_t i = first; i < end; i++) {
+        int type = m_results.RowType(i);
+        std::string valStr = GetAddressValue(m_results.Addr(i), type);
 
-        printf("\e[37;1mAddr:\e[32;1m0x%lX  \e[37;1mType:\e[36;1m%s  \e[37;1mValue:\e[35;1m%s\n", res.addr, typeStr, valStr.c_str());
-        
-        if (++count >= 100) {
-            printf("... (Showing first 100 of %zu results)\n", m_results.size());
-            break;
-        }
+        printf("\e[37;1mAddr:\e[32;1m0x%lX  \e[37;1mType:\e[36;1m%s  \e[37;1mValue:\e[35;1m%s\n", m_results.Addr(i), GetTypeInfo(type).name, valStr.c_str());
+    }
+    if (first > 0 || end < m_results.Size()) {
+        printf("... (Showing rows %zu-%zu of %zu results)\n", std::min(first, end), end, m_results.Size());
     }
 }
 
@@ -423,59 +1203,1437 @@ void MemoryTool::PrintResults() {
 // Freeze Logic
 // ==============================================================================================
 
-void MemoryTool::AddFreezeItem(ADDRESS addr, const char* value, int type, long int offset) {
+void MemoryTool::AddFreezeItem(ADDRESS addr, const char* value, int type, long int offset, int periodUs) {
     FreezeItem item;
     item.addr = addr + offset;
     item.type = type;
     item.value = value;
+    item.periodUs = periodUs;
+    item.size = (uint8_t)EncodeValue(value, type, item.bytes);
+    if (item.size == 0) return;
+    std::lock_guard<std::mutex> lock(m_freezeMutex);
     m_freezeItems.push_back(item);
+    m_freezeDirty = true;
 }
 
-void MemoryTool::AddFreezeItem_All(const char* value, int type, long int offset) {
-    for (const auto& res : m_results) {
-        AddFreezeItem(res.addr, value, type, offset);
+void MemoryTool::AddFreezeItem_All(const char* value, int type, long int offset, int periodUs) {
+    for (size_t i = 0; i < m_results.Size(); i++) {
+        AddFreezeItem(m_results.Addr(i), value, type, offset, periodUs);
     }
 }
 
-void MemoryTool::RemoveFreezeItem(ADDRESS addr) {
+size_t MemoryTool::RemoveFreezeItem(ADDRESS addr) {
+    std::lock_guard<std::mutex> lock(m_freezeMutex);
     auto it = std::remove_if(m_freezeItems.begin(), m_freezeItems.end(), 
         [addr](const FreezeItem& item){ return item.addr == addr; });
     m_freezeItems.erase(it, m_freezeItems.end());
+    m_freezeDirty = true;
+    return m_freezeItems.size();
+}
+
+void MemoryTool::SetFreezeItemPeriod(ADDRESS addr, int periodUs) {
+    std::lock_guard<std::mutex> lock(m_freezeMutex);
+    for (auto& item : m_freezeItems) {
+        if (item.addr == addr) item.periodUs = periodUs;
+    }
+    m_freezeDirty = true;
 }
 
 void MemoryTool::ClearFreezeItems() {
+    std::lock_guard<std::mutex> lock(m_freezeMutex);
     m_freezeItems.clear();
+    m_freezeDirty = true;
 }
 
 void MemoryTool::PrintFreezeItems() {
+    std::lock_guard<std::mutex> lock(m_freezeMutex);
     for (const auto& item : m_freezeItems) {
-        printf("FreezeAddr:0x%lX  Type:%d  Value:%s\n", item.addr, item.type, item.value.c_str());
+        printf("FreezeAddr:0x%lX  Type:%d  Value:%s  Period:%dus  Overwritten:%llu\n", item.addr, item.type, item.value.c_str(),
+               item.periodUs > 0 ? item.periodUs : m_freezeDelay, (unsigned long long)item.overwrites);
     }
 }
 
+// Into the caller's vector: the overlay keeps one between frames, so copies stop allocating
+void MemoryTool::GetFreezeStats(std::vector<FreezeStats>& out) {
+    std::lock_guard<std::mutex> lock(m_freezeMutex);
+    out.assign(m_freezeStats.begin(), m_freezeStats.end());
+}
+
 void MemoryTool::StartFreeze() {
     if (m_isFreezing) return;
+    if (m_freezeThread.joinable()) m_freezeThread.join(); // Previous loop exited on its own (target died)
     m_isFreezing = true;
+    m_freezeDirty = true;
     m_freezeThread = std::thread(&MemoryTool::FreezeThreadLoop, this);
-    m_freezeThread.detach(); // Detach to let it run in bg
 }
 
 void MemoryTool::StopFreeze() {
     m_isFreezing = false;
-    // Thread will exit on next loop check
+    // The scheduler never sleeps longer than FREEZE_MAX_SLEEP_NS, so this join is short
+    if (m_freezeThread.joinable() && m_freezeThread.get_id() != std::this_thread::get_id()) {
+        m_freezeThread.join();
+    }
+}
+
+// Freeze scheduler: a hashed timer wheel of period groups driven by absolute
+// CLOCK_MONOTONIC deadlines, so the write time never accumulates into the period.
+static const int64_t FREEZE_TICK_NS = 100 * 1000;           // Wheel resolution, also the minimum period
+static const size_t FREEZE_WHEEL_SLOTS = 512;               // One revolution = 51.2ms
+static const int64_t FREEZE_MAX_SLEEP_NS = 20 * 1000 * 1000; // Bound on any single sleep, keeps StopFreeze responsive
+static const size_t FREEZE_JITTER_SAMPLES = 256;
+
+static inline int64_t MonotonicNs() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+static inline void SleepUntilNs(int64_t deadline) {
+    struct timespec ts;
+    ts.tv_sec = deadline / 1000000000LL;
+    ts.tv_nsec = deadline % 1000000000LL;
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+}
+
+namespace {
+// A frozen value as the freeze thread writes it: copied from its FreezeItem at regroup, so
+// ticks write without holding m_freezeMutex
+struct FreezeField {
+    ADDRESS addr;
+    uint8_t bytes[8];
+    uint8_t size;
+    uint64_t overwrites; // Not yet added to the item's count
+};
+
+struct FreezeGroup {
+    int periodUs = 0;
+    std::vector<size_t> items;  // Indices into m_freezeItems sorted by address, valid until the next regroup
+    std::vector<FreezeField> fields; // Parallel to items
+    // Compare mode layout: spans over items, plus the target image and field mask in span-buffer order
+    std::vector<ReadSpan> spans;
+    std::vector<uint8_t> current;
+    std::vector<uint8_t> target;
+    std::vector<uint8_t> mask;
+    std::vector<uint8_t> diff;
+    int64_t deadline = 0;       // Absolute CLOCK_MONOTONIC ns of the next rewrite
+    uint32_t rounds = 0;        // Wheel revolutions left before the deadline's slot is live
+    int64_t firstFire = 0;
+    int64_t lastFire = 0;
+    uint64_t ticks = 0;
+    uint64_t overruns = 0;
+    std::vector<int64_t> lateNs; // Ring of recent deadline lateness samples
+    size_t latePos = 0;
+};
+
+// 'scratch' takes the copy nth_element reorders, so the sample ring keeps its order and
+// repeated calls reuse one buffer
+double PercentileUs(const std::vector<int64_t>& samples, double pct, std::vector<int64_t>& scratch) {
+    if (samples.empty()) return 0.0;
+    scratch.assign(samples.begin(), samples.end());
+    size_t k = (size_t)(pct * (scratch.size() - 1));
+    std::nth_element(scratch.begin(), scratch.begin() + k, scratch.end());
+    return scratch[k] / 1000.0;
+}
 }
 
 void MemoryTool::FreezeThreadLoop() {
+    std::vector<FreezeGroup> groups;
+    std::vector<std::vector<int>> wheel(FREEZE_WHEEL_SLOTS);
+    size_t cursor = 0;
+    int64_t wheelTime = MonotonicNs(); // Start time of the slot under the cursor
+    int64_t nextPidCheck = 0;
+    int64_t nextPublish = 0;
+    std::vector<int64_t> percentileScratch; // Reused by every stats publish
+
+    // Slot offset is at least 1: the cursor slot is the one being drained. A whole number of
+    // revolutions lands back in the cursor slot, which the cursor reaches one revolution from
+    // now, hence offset - 1.
+    auto place = [&](int g) {
+        int64_t delta = groups[g].deadline - wheelTime;
+        size_t offset = delta > 0 ? (size_t)(delta / FREEZE_TICK_NS) : 0;
+        if (offset == 0) offset = 1;
+        groups[g].rounds = (uint32_t)((offset - 1) / FREEZE_WHEEL_SLOTS);
+        wheel[(cursor + offset) % FREEZE_WHEEL_SLOTS].push_back(g);
+    };
+
+    // Sort the group by address, copy its fields and lay them out for one batched read per span.
+    // Runs under m_freezeMutex.
+    auto buildLayout = [&](FreezeGroup& g) {
+        std::sort(g.items.begin(), g.items.end(), [&](size_t a, size_t b) { return m_freezeItems[a].addr < m_freezeItems[b].addr; });
+        g.fields.resize(g.items.size());
+        for (size_t i = 0; i < g.items.size(); i++) {
+            const FreezeItem& item = m_freezeItems[g.items[i]];
+            FreezeField& field = g.fields[i];
+            field.addr = item.addr;
+            memcpy(field.bytes, item.bytes, sizeof(field.bytes));
+            field.size = item.size;
+            field.overwrites = 0;
+        }
+        g.spans = BuildReadSpans(g.fields.size(),
+            [&](size_t i) { return g.fields[i].addr; },
+            [&](size_t i) { return (size_t)g.fields[i].size; });
+        size_t total = g.spans.empty() ? 0 : g.spans.back().bufOffset + g.spans.back().len;
+        g.current.assign(total, 0);
+        g.target.assign(total, 0);
+        g.mask.assign(total, 0);
+        g.diff.assign(total, 0);
+        for (const auto& span : g.spans) {
+            for (uint32_t i = span.first; i < span.first + span.count; i++) {
+                const FreezeField& field = g.fields[i];
+                size_t off = span.bufOffset + (field.addr - span.addr);
+                memcpy(&g.target[off], field.bytes, field.size);
+                memset(&g.mask[off], 0xFF, field.size);
+            }
+        }
+    };
+
+    // Adds the overwrites counted since the last flush to the items. Under m_freezeMutex, with
+    // m_freezeItems as the groups were built from.
+    auto flushOverwrites = [&]() {
+        for (auto& g : groups) {
+            for (size_t i = 0; i < g.fields.size(); i++) {
+                m_freezeItems[g.items[i]].overwrites += g.fields[i].overwrites;
+                g.fields[i].overwrites = 0;
+            }
+        }
+    };
+
+    // Rebuild period groups from the item list, keeping phase and stats of surviving periods
+    auto regroup = [&]() {
+        std::vector<FreezeGroup> old;
+        old.swap(groups);
+        int64_t now = MonotonicNs();
+        std::lock_guard<std::mutex> lock(m_freezeMutex);
+        m_freezeDirty = false;
+        // The list changed since the groups were built, so pending counts go by address
+        for (const auto& g : old) {
+            for (const auto& field : g.fields) {
+                if (!field.overwrites) continue;
+                auto it = std::find_if(m_freezeItems.begin(), m_freezeItems.end(),
+                                       [&field](const FreezeItem& item) { return item.addr == field.addr; });
+                if (it != m_freezeItems.end()) it->overwrites += field.overwrites;
+            }
+        }
+        for (size_t i = 0; i < m_freezeItems.size(); i++) {
+            int period = m_freezeItems[i].periodUs > 0 ? m_freezeItems[i].periodUs : m_freezeDelay;
+            if (period < FREEZE_TICK_NS / 1000) period = FREEZE_TICK_NS / 1000;
+            auto it = std::find_if(groups.begin(), groups.end(), [period](const FreezeGroup& g) { return g.periodUs == period; });
+            if (it == groups.end()) {
+                groups.emplace_back();
+                it = groups.end() - 1;
+                it->periodUs = period;
+            }
+            it->items.push_back(i);
+        }
+        for (auto& g : groups) {
+            auto prev = std::find_if(old.begin(), old.end(), [&g](const FreezeGroup& o) { return o.periodUs == g.periodUs; });
+            if (prev != old.end()) {
+                std::vector<size_t> items = std::move(g.items);
+                g = std::move(*prev);
+                g.items = std::move(items);
+            } else {
+                g.deadline = now;
+                g.lateNs.reserve(FREEZE_JITTER_SAMPLES);
+            }
+            buildLayout(g);
+        }
+        for (auto& slot : wheel) slot.clear();
+        for (int g = 0; g < (int)groups.size(); g++) place(g);
+    };
+
+    // Compare mode: read every span, XOR against the target image under the field mask,
+    // and only write the items whose bytes differ. Unreadable spans are written blind.
+    auto writeDiverged = [&](FreezeGroup& g) {
+        for (const auto& span : g.spans) {
+            uint8_t* cur = g.current.data() + span.bufOffset;
+            const uint8_t* tgt = g.target.data() + span.bufOffset;
+            const uint8_t* msk = g.mask.data() + span.bufOffset;
+            uint8_t* dif = g.diff.data() + span.bufOffset;
+            bool readOk = kpm.read_raw(span.addr, cur, span.len) == span.len;
+
+            uint64_t any = 0;
+            if (readOk) {
+                // Word-wise so the compiler can vectorize it; most spans come out all-zero
+                size_t n = span.len;
+                size_t w = 0;
+                for (; w + 8 <= n; w += 8) {
+                    uint64_t c, t, m;
+                    memcpy(&c, cur + w, 8); memcpy(&t, tgt + w, 8); memcpy(&m, msk + w, 8);
+                    uint64_t d = (c ^ t) & m;
+                    memcpy(dif + w, &d, 8);
+                    any |= d;
+                }
+                for (; w < n; w++) {
+                    dif[w] = (cur[w] ^ tgt[w]) & msk[w];
+                    any |= dif[w];
+                }
+                if (!any) continue;
+            }
+
+            for (uint32_t i = span.first; i < span.first + span.count; i++) {
+                FreezeField& field = g.fields[i];
+                if (readOk) {
+                    size_t off = span.bufOffset + (field.addr - span.addr);
+                    uint64_t d = 0;
+                    memcpy(&d, dif + off, field.size);
+                    if (!d) continue;
+                    field.overwrites++;
+                }
+                kpm.write_raw(field.addr, field.bytes, field.size);
+            }
+        }
+    };
+
+    auto fire = [&](FreezeGroup& g) {
+        int64_t start = MonotonicNs();
+        // Writes come from the group's own copy: the UI can hold m_freezeMutex for a whole frame
+        if (m_freezeDirty) return; // Item list changed, regroup runs before the next slot
+        if (m_freezeCompare) writeDiverged(g);
+        else {
+            for (const FreezeField& field : g.fields) kpm.write_raw(field.addr, field.bytes, field.size);
+        }
+        int64_t late = start - g.deadline;
+        if (g.lateNs.size() < FREEZE_JITTER_SAMPLES) g.lateNs.push_back(late);
+        else g.lateNs[g.latePos++ % FREEZE_JITTER_SAMPLES] = late;
+        if (g.ticks == 0) g.firstFire = start;
+        g.lastFire = start;
+        g.ticks++;
+
+        int64_t period = (int64_t)g.periodUs * 1000;
+        g.deadline += period;
+        int64_t now = MonotonicNs();
+        if (g.deadline <= now) {
+            // Writes ran past the next deadline: skip the missed ones instead of bursting to catch up
+            int64_t missed = (now - g.deadline) / period + 1;
+            g.deadline += missed * period;
+            g.overruns += missed;
+        }
+    };
+
+    auto publish = [&]() {
+        std::vector<FreezeStats> stats;
+        stats.reserve(groups.size());
+        for (const auto& g : groups) {
+            FreezeStats st;
+            st.periodUs = g.periodUs;
+            st.itemCount = g.items.size();
+            st.ticks = g.ticks;
+            st.overruns = g.overruns;
+            st.achievedPeriodUs = g.ticks > 1 ? (g.lastFire - g.firstFire) / 1000.0 / (g.ticks - 1) : 0.0;
+            st.jitterP50Us = PercentileUs(g.lateNs, 0.50, percentileScratch);
+            st.jitterP99Us = PercentileUs(g.lateNs, 0.99, percentileScratch);
+            st.jitterMaxUs = g.lateNs.empty() ? 0.0 : *std::max_element(g.lateNs.begin(), g.lateNs.end()) / 1000.0;
+            stats.push_back(st);
+        }
+        std::lock_guard<std::mutex> lock(m_freezeMutex);
+        m_freezeStats = std::move(stats);
+        if (!m_freezeDirty) flushOverwrites(); // Else regroup flushes them by address
+    };
+
     while (m_isFreezing) {
-        // Check if process still alive?
-        int pid = getPID(m_pkgName.c_str());
-        if (pid <= 0) break;
+        int64_t now = MonotonicNs();
+        if (now >= nextPidCheck) {
+            // Check if process still alive (walking /proc is too slow to do every tick)
+            if (getPID(m_pkgName.c_str()) <= 0) break;
+            nextPidCheck = now + 1000000000LL;
+        }
+        if (m_freezeDirty) regroup();
+
+        // Drain the cursor slot: due groups fire at their exact deadline, the rest wait another revolution
+        std::vector<int> slot;
+        slot.swap(wheel[cursor]);
+        std::vector<int> due;
+        for (int g : slot) {
+            if (groups[g].rounds > 0) {
+                groups[g].rounds--;
+                wheel[cursor].push_back(g);
+            } else {
+                due.push_back(g);
+            }
+        }
+        std::sort(due.begin(), due.end(), [&](int a, int b) { return groups[a].deadline < groups[b].deadline; });
+        for (int g : due) {
+            SleepUntilNs(groups[g].deadline);
+            fire(groups[g]);
+            place(g);
+        }
+
+        if (now >= nextPublish) {
+            publish();
+            nextPublish = now + 250 * 1000000LL;
+        }
+
+        // Skip ahead to the next occupied slot, but never sleep past FREEZE_MAX_SLEEP_NS
+        size_t step = 1;
+        size_t maxStep = (size_t)(FREEZE_MAX_SLEEP_NS / FREEZE_TICK_NS);
+        while (step < maxStep && wheel[(cursor + step) % FREEZE_WHEEL_SLOTS].empty()) step++;
+        cursor = (cursor + step) % FREEZE_WHEEL_SLOTS;
+        wheelTime += (int64_t)step * FREEZE_TICK_NS;
+        SleepUntilNs(wheelTime);
+    }
+    publish();
+    m_isFreezing = false;
+}
+
+// ==============================================================================================
+// Watch List
+// ==============================================================================================
+
+std::shared_ptr<WatchItem> MemoryTool::AddWatchItem(ADDRESS addr, int type) {
+    if (GetTypeInfo(type).size == 0) return nullptr;
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    for (const auto& item : m_watchItems) {
+        if (item->addr == addr && item->type == type) return item;
+    }
+    auto item = std::make_shared<WatchItem>();
+    item->addr = addr;
+    item->type = type;
+    m_watchItems.push_back(item);
+    m_watchDirty = true;
+    return item;
+}
+
+void MemoryTool::RemoveWatchItem(ADDRESS addr) {
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    auto it = std::remove_if(m_watchItems.begin(), m_watchItems.end(),
+        [addr](const std::shared_ptr<WatchItem>& item) { return item->addr == addr; });
+    m_watchItems.erase(it, m_watchItems.end());
+    m_watchDirty = true;
+}
+
+void MemoryTool::ClearWatchItems() {
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    m_watchItems.clear();
+    m_watchDirty = true;
+}
+
+void MemoryTool::GetWatchItems(std::vector<std::shared_ptr<WatchItem>>& out) {
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    out.assign(m_watchItems.begin(), m_watchItems.end());
+}
+
+void MemoryTool::SetWatchRate(int hz) {
+    m_watchRateHz = std::max(1, std::min(hz, MAX_WATCH_RATE));
+}
+
+WatchStats MemoryTool::GetWatchStats() {
+    std::lock_guard<std::mutex> lock(m_watchMutex);
+    return m_watchStats;
+}
+
+void MemoryTool::StartWatch() {
+    if (m_isWatching) return;
+    if (m_watchThread.joinable()) m_watchThread.join(); // Previous loop exited on its own (target died)
+    m_isWatching = true;
+    m_watchDirty = true;
+    m_watchThread = std::thread(&MemoryTool::WatchThreadLoop, this);
+}
+
+void MemoryTool::StopWatch() {
+    m_isWatching = false;
+    // A round sleeps at most one period, and the slowest rate is 1 Hz
+    if (m_watchThread.joinable() && m_watchThread.get_id() != std::this_thread::get_id()) {
+        m_watchThread.join();
+    }
+}
+
+// Watch sampler: one round per period on absolute deadlines, like the freeze scheduler. Items
+// are sorted by address and coalesced into spans once per list change; a round is then a single
+// batched read of all spans and a decode of every item from the span buffer.
+void MemoryTool::WatchThreadLoop() {
+    std::vector<std::shared_ptr<WatchItem>> items; // Sorted by address, held so removal can't free them mid-round
+    std::vector<ReadSpan> spans;
+    std::vector<kpm_read_span> reads;
+    std::vector<uint32_t> itemOffset; // Where each item lands in 'buffer'
+    std::vector<double> lastValue;    // Previous sample of each item, to notify on changes only
+    std::vector<uint8_t> buffer;
+    size_t pages = 0;
+
+    auto rebuild = [&]() {
+        {
+            std::lock_guard<std::mutex> lock(m_watchMutex);
+            items = m_watchItems;
+            m_watchDirty = false;
+        }
+        std::sort(items.begin(), items.end(),
+            [](const std::shared_ptr<WatchItem>& a, const std::shared_ptr<WatchItem>& b) { return a->addr < b->addr; });
+        spans = BuildReadSpans(items.size(),
+            [&](size_t i) { return items[i]->addr; },
+            [&](size_t i) { return GetTypeInfo(items[i]->type).size; });
+        size_t total = spans.empty() ? 0 : spans.back().bufOffset + spans.back().len;
+        buffer.assign(total, 0);
+        reads.resize(spans.size());
+        itemOffset.resize(items.size());
+        lastValue.assign(items.size(), std::numeric_limits<double>::quiet_NaN());
+        for (size_t s = 0; s < spans.size(); s++) {
+            const ReadSpan& span = spans[s];
+            reads[s] = { span.addr, buffer.data() + span.bufOffset, span.len, 0 };
+            for (uint32_t k = 0; k < span.count; k++) {
+                size_t i = span.first + k;
+                itemOffset[i] = span.bufOffset + (uint32_t)(items[i]->addr - span.addr);
+            }
+        }
+        pages = 0;
+        ADDRESS lastPage = ~(ADDRESS)0;
+        for (const auto& item : items) {
+            ADDRESS first = item->addr >> 12, last = (item->addr + GetTypeInfo(item->type).size - 1) >> 12;
+            for (ADDRESS p = first; p <= last; p++) {
+                if (p != lastPage) { pages++; lastPage = p; }
+            }
+        }
+    };
+
+    int64_t deadline = MonotonicNs();
+    int64_t nextPidCheck = 0;
+    int64_t nextPublish = 0;
+    int64_t windowStart = deadline, roundNs = 0;
+    uint64_t rounds = 0, missed = 0;
+
+    while (m_isWatching) {
+        int64_t now = MonotonicNs();
+        if (now >= nextPidCheck) {
+            if (getPID(m_pkgName.c_str()) <= 0) break;
+            nextPidCheck = now + 1000000000LL;
+        }
+        if (m_watchDirty) rebuild();
+
+        int64_t start = MonotonicNs();
+        bool changed = false;
+        for (auto& r : reads) r.got = 0;
+        kpm.read_spans(reads.data(), reads.size());
+        for (size_t s = 0; s < spans.size(); s++) {
+            const ReadSpan& span = spans[s];
+            for (uint32_t k = 0; k < span.count; k++) {
+                size_t i = span.first + k;
+                WatchItem& item = *items[i];
+                uint32_t end = (uint32_t)(item.addr - span.addr) + (uint32_t)GetTypeInfo(item.type).size;
+                if (reads[s].got < end) {
+                    item.failedReads.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                double value = ValueAsDouble(buffer.data() + itemOffset[i], item.type);
+                // NaN never equals itself; compare bits so a NaN that stays put is not a change
+                if (memcmp(&value, &lastValue[i], sizeof(value)) != 0) {
+                    lastValue[i] = value;
+                    changed = true;
+                }
+                item.samples.Push(start, value);
+            }
+        }
+        if (changed) NotifyChange(EVENT_WATCH);
+        int64_t end = MonotonicNs();
+        roundNs += end - start;
+        rounds++;
+
+        if (end >= nextPublish) {
+            WatchStats st;
+            st.items = items.size();
+            st.spans = spans.size();
+            st.pages = pages;
+            st.rateHz = m_watchRateHz;
+            st.achievedHz = end > windowStart ? rounds * 1e9 / (end - windowStart) : 0.0;
+            st.roundUs = rounds ? roundNs / 1000.0 / rounds : 0.0;
+            st.missedRounds = missed;
+            {
+                std::lock_guard<std::mutex> lock(m_watchMutex);
+                m_watchStats = st;
+            }
+            windowStart = end;
+            roundNs = 0;
+            rounds = 0;
+            nextPublish = end + 500 * 1000000LL;
+        }
+
+        int64_t period = 1000000000LL / std::max(1, m_watchRateHz.load());
+        deadline += period;
+        if (deadline <= end) {
+            // The round ran past the next deadline: skip the missed ones instead of bursting to catch up
+            int64_t skip = (end - deadline) / period + 1;
+            deadline += skip * period;
+            missed += skip;
+        }
+        SleepUntilNs(deadline);
+    }
+    m_isWatching = false;
+}
+
+bool MemoryTool::TraceAccess(ADDRESS addr, int type, int kind) {
+    size_t size = GetTypeInfo(type).size;
+    if (size == 0 || kpm.get_pid() <= 0) return false;
+    return m_tracer.Start(kpm.get_pid(), addr, size, kind);
+}
+
+// ==============================================================================================
+// Refine History
+// ==============================================================================================
+
+// Levels farther than this from the current one keep only their removal bitmap. A weak refine
+// leaves a level almost as large as its parent, so keeping more than the neighbours could hold
+// about as many rows again as the scan itself.
+static const size_t HISTORY_SNAPSHOT_REACH = 1;
+
+void MemoryTool::CommitRefine(ResultStore&& results, std::vector<uint64_t>&& removed, const char* label) {
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    if (m_history.empty()) {
+        // Results that never came from a scan (e.g. loaded); treat them as the root
+        m_history.emplace_back();
+        m_history[0].label = "Scan";
+        m_history[0].count = m_results.Size();
+        m_history[0].type = m_results.type;
+    }
+    // A refine after undo replaces the redo levels
+    m_history.resize(m_historyPos + 1);
+
+    // The parent's rows are the old m_results: keep them instead of freeing them
+    m_history[m_historyPos].snapshot.reset(new ResultStore());
+    m_history[m_historyPos].snapshot->Swap(m_results);
+
+    HistoryLevel level;
+    level.label = label;
+    level.count = results.Size();
+    level.type = results.type;
+    level.removed = std::move(removed);
+    m_history.push_back(std::move(level));
+    m_historyPos++;
+    m_results.Swap(results);
+    m_resultsGen++;
+    EvictSnapshots();
+}
+
+// Rebuilds an evicted level from its nearest materialized ancestor by replaying the removal
+// bitmaps. Rebuilt levels have no value column: the parent's values predate the refine. Their
+// type masks are the parent's, a superset of what an AUTO refine narrowed them to.
+// Runs without m_resultsMutex: only the job thread changes m_history and m_results.
+std::unique_ptr<ResultStore> MemoryTool::RebuildLevel(size_t level) {
+    auto rowsOf = [&](size_t l) -> const ResultStore* {
+        return l == m_historyPos ? &m_results : m_history[l].snapshot.get();
+    };
+    size_t base = level;
+    while (base > 0 && !rowsOf(base)) base--;
+    if (!rowsOf(base)) return nullptr; // The scan's own rows are gone; nothing to replay from
+
+    std::unique_ptr<ResultStore> current;
+    const ResultStore* parent = rowsOf(base);
+    for (size_t l = base + 1; l <= level; l++) {
+        std::unique_ptr<ResultStore> next(new ResultStore());
+        next->type = m_history[l].type;
+        if (next->type == TYPE_AUTO) next->EnableTypeMasks();
+        next->AppendKept(*parent, m_history[l].removed.data());
+        current = std::move(next);
+        parent = current.get();
+    }
+    return current;
+}
+
+// Drops the snapshots of levels out of reach of the current one; the scan's own snapshot stays
+void MemoryTool::EvictSnapshots() {
+    for (size_t l = 1; l < m_history.size(); l++) {
+        size_t dist = l > m_historyPos ? l - m_historyPos : m_historyPos - l;
+        if (dist > HISTORY_SNAPSHOT_REACH) m_history[l].snapshot.reset();
+    }
+}
+
+// Job thread: an evicted target is replayed before m_resultsMutex is taken, so the overlay,
+// which holds it while drawing results, only ever waits for the swaps
+bool MemoryTool::MoveToLevel(size_t target) {
+    std::unique_ptr<ResultStore> rebuilt;
+    if (!m_history[target].snapshot) {
+        rebuilt = RebuildLevel(target);
+        if (!rebuilt) return false;
+    }
+
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    if (rebuilt) m_history[target].snapshot = std::move(rebuilt);
+    m_history[m_historyPos].snapshot.reset(new ResultStore());
+    m_history[m_historyPos].snapshot->Swap(m_results);
+    m_results.Swap(*m_history[target].snapshot);
+    m_resultsGen++;
+    m_history[target].snapshot.reset();
+    m_historyPos = target;
+    EvictSnapshots();
+    return true;
+}
+
+bool MemoryTool::UndoResults() {
+    if (m_historyPos == 0) return false;
+    return MoveToLevel(m_historyPos - 1);
+}
+
+bool MemoryTool::RedoResults() {
+    if (m_historyPos + 1 >= m_history.size()) return false;
+    return MoveToLevel(m_historyPos + 1);
+}
+
+int MemoryTool::GetHistoryPos() {
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    return (int)m_historyPos;
+}
+
+int MemoryTool::GetHistoryDepth() {
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    return (int)m_history.size();
+}
 
+void MemoryTool::GetHistoryLabel(int level, char* out, size_t size) {
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    if (level < 0 || level >= (int)m_history.size()) {
+        if (size) out[0] = '\0';
+        return;
+    }
+    snprintf(out, size, "%s (%zu)", m_history[level].label.c_str(), m_history[level].count);
+}
+
+// ==============================================================================================
+// Result View
+// ==============================================================================================
+
+// Sorts 'parts' slices on their own threads, then merges neighbouring slices pairwise, each
+// round of merges in parallel too
+template <typename T, typename Less>
+static void ParallelSort(std::vector<T>& v, Less less) {
+    size_t parts = v.size() < 100000 ? 1 : std::max(1u, std::thread::hardware_concurrency());
+    std::vector<size_t> bounds(parts + 1);
+    for (size_t p = 0; p <= parts; p++) bounds[p] = v.size() * p / parts;
+    auto at = [&](size_t p) { return v.begin() + bounds[std::min(p, parts)]; };
+
+    std::vector<std::thread> threads;
+    for (size_t p = 1; p < parts; p++) threads.emplace_back([&, p] { std::sort(at(p), at(p + 1), less); });
+    std::sort(at(0), at(1), less);
+    for (auto& t : threads) t.join();
+
+    for (size_t width = 1; width < parts; width *= 2) {
+        threads.clear();
+        for (size_t p = 2 * width; p + width < parts; p += 2 * width) {
+            threads.emplace_back([&, p, width] { std::inplace_merge(at(p), at(p + width), at(p + 2 * width), less); });
+        }
+        std::inplace_merge(at(0), at(width), at(2 * width), less);
+        for (auto& t : threads) t.join();
+    }
+}
+
+// Double bits ordered like the doubles: negatives flipped whole, positives by the sign bit
+static inline uint64_t OrderedBits(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (1ULL << 63);
+}
+
+void MemoryTool::BuildResultView(const ViewQuery& query) {
+    auto start = std::chrono::steady_clock::now();
+    uint64_t generation;
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        generation = m_resultsGen;
+    }
+    // Only jobs change m_results, and this is one, so the rows hold still from here on
+    const ResultStore& results = m_results;
+    const size_t n = results.Size();
+    if (n > UINT32_MAX) {
+        printf("[-] View: %zu rows are more than a view can index\n", n);
+        return;
+    }
+    auto view = std::make_shared<ResultView>();
+    view->query = query;
+    view->generation = generation;
+    view->readValues = query.valueFilter || query.sortKey == SORT_VALUE || query.sortKey == SORT_CHANGES;
+    BeginProgress(view->readValues ? n * 2 : n);
+
+    // Current values as doubles, NaN where unreadable. Spans go to the backend in batches.
+    std::vector<double> values;
+    if (view->readValues) {
+        values.assign(n, std::nan(""));
+        const ADDRESS* addrs = results.Addrs();
+        std::vector<ReadSpan> spans = BuildReadSpans(n,
+            [&](size_t i) { return addrs[i]; },
+            [&](size_t i) { return GetTypeInfo(results.RowType(i)).size; });
+        const size_t BATCH = 64;
+        std::vector<uint8_t> buffer(BATCH * SPAN_MAX_LEN);
+        std::vector<kpm_read_span> reads(BATCH);
+        for (size_t s0 = 0; s0 < spans.size() && !m_progress.cancel; s0 += BATCH) {
+            size_t count = std::min(BATCH, spans.size() - s0);
+            for (size_t k = 0; k < count; k++) reads[k] = { spans[s0 + k].addr, buffer.data() + k * SPAN_MAX_LEN, spans[s0 + k].len, 0 };
+            kpm.read_spans(reads.data(), count);
+            for (size_t k = 0; k < count; k++) {
+                const ReadSpan& span = spans[s0 + k];
+                for (uint32_t j = 0; j < span.count; j++) {
+                    size_t i = span.first + j;
+                    int type = results.RowType(i);
+                    size_t at = (size_t)(addrs[i] - span.addr);
+                    if (reads[k].got >= at + GetTypeInfo(type).size) values[i] = ValueAsDouble(buffer.data() + k * SPAN_MAX_LEN + at, type);
+                }
+                m_progress.bytesDone += span.count;
+            }
+        }
+        if (m_progress.cancel) return;
+
+        // Change counts carry over between builds of the same rows
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        if (m_resultsGen != generation) return;
+        if (m_changeGen != generation || m_changeCounts.size() != n) {
+            m_changeCounts.assign(n, 0);
+            m_lastValues.resize(n);
+            for (size_t i = 0; i < n; i++) memcpy(&m_lastValues[i], &values[i], sizeof(uint64_t));
+            m_changeGen = generation;
+        } else {
+            for (size_t i = 0; i < n; i++) {
+                uint64_t bits;
+                memcpy(&bits, &values[i], sizeof(bits));
+                if (bits != m_lastValues[i] && values[i] == values[i]) {
+                    m_changeCounts[i]++;
+                    m_lastValues[i] = bits;
+                }
+            }
+        }
+    }
+
+    // Filter: address range by binary search, region per run, value per row
+    std::vector<uint8_t> runMatches(results.RegionRunCount(), 1);
+    if (!query.regionFilter.empty()) {
+        for (size_t r = 0; r < runMatches.size(); r++) {
+            runMatches[r] = results.RegionRunName(r).find(query.regionFilter) != std::string::npos;
+        }
+    }
+    size_t lo = results.LowerBound(query.addrMin);
+    size_t hi = query.addrMax == ~(ADDRESS)0 ? n : results.LowerBound(query.addrMax + 1);
+    view->rows.reserve(hi > lo ? hi - lo : 0);
+    for (size_t r = 0; r < runMatches.size(); r++) {
+        if (!runMatches[r]) continue;
+        size_t first = std::max(lo, results.RegionRunFirstRow(r));
+        size_t end = std::min(hi, r + 1 < runMatches.size() ? results.RegionRunFirstRow(r + 1) : n);
+        for (size_t i = first; i < end; i++) {
+            if (query.valueFilter && !(values[i] >= query.valueMin && values[i] <= query.valueMax)) continue;
+            view->rows.push_back((uint32_t)i);
+        }
+    }
+    m_progress.bytesDone += n;
+
+    // Sort (key, row) pairs; ties keep address order
+    if (query.sortKey != SORT_ADDRESS) {
+        struct Entry {
+            uint64_t key;
+            uint32_t row;
+        };
+        std::vector<Entry> entries(view->rows.size());
+        std::vector<uint32_t> regionRank;
+        if (query.sortKey == SORT_REGION) {
+            std::vector<std::string> names;
+            for (size_t r = 0; r < results.RegionRunCount(); r++) names.push_back(results.RegionRunName(r));
+            std::sort(names.begin(), names.end());
+            names.erase(std::unique(names.begin(), names.end()), names.end());
+            for (size_t r = 0; r < results.RegionRunCount(); r++) {
+                regionRank.push_back((uint32_t)(std::lower_bound(names.begin(), names.end(), results.RegionRunName(r)) - names.begin()));
+            }
+        }
+        size_t run = 0;
+        for (size_t k = 0; k < entries.size(); k++) {
+            uint32_t row = view->rows[k];
+            uint64_t key = 0;
+            switch (query.sortKey) {
+                case SORT_VALUE: key = values[row] == values[row] ? OrderedBits(values[row]) : ~0ULL; break; // Unreadable last
+                case SORT_REGION:
+                    while (run + 1 < regionRank.size() && results.RegionRunFirstRow(run + 1) <= row) run++;
+                    key = regionRank[run];
+                    break;
+                case SORT_CHANGES: key = m_changeCounts[row]; break;
+            }
+            entries[k] = { key, row };
+        }
+        const bool desc = query.descending;
+        ParallelSort(entries, [desc](const Entry& a, const Entry& b) {
+            if (a.key != b.key) return desc ? a.key > b.key : a.key < b.key;
+            return a.row < b.row;
+        });
+        for (size_t k = 0; k < entries.size(); k++) view->rows[k] = entries[k].row;
+    } else if (query.descending) {
+        std::reverse(view->rows.begin(), view->rows.end());
+    }
+
+    view->buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    static const char* keyNames[] = { "address", "value", "region", "changes" };
+    printf("View: %zu of %zu rows by %s in %.0f ms\n", view->rows.size(), n, keyNames[query.sortKey & 3], view->buildMs);
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    if (m_resultsGen == generation) m_resultView = std::move(view);
+}
+
+const ResultView* MemoryTool::GetResultView() const {
+    return m_resultView && m_resultView->generation == m_resultsGen ? m_resultView.get() : nullptr;
+}
+
+uint32_t MemoryTool::GetChangeCount(size_t row) const {
+    return m_changeGen == m_resultsGen && row < m_changeCounts.size() ? m_changeCounts[row] : 0;
+}
+
+void MemoryTool::ClearResultView() {
+    m_resultView.reset();
+}
+
+// ==============================================================================================
+// Named Result Sets
+// ==============================================================================================
+
+void MemoryTool::SaveResultSet(const char* name) {
+    std::shared_ptr<ResultStore> copy = std::make_shared<ResultStore>();
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        *copy = m_results;
+    }
+    std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+    m_resultSets[name] = copy;
+}
+
+bool MemoryTool::LoadResultSet(const char* name) {
+    std::shared_ptr<const ResultStore> set;
+    {
+        std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+        auto it = m_resultSets.find(name);
+        if (it == m_resultSets.end()) return false;
+        set = it->second;
+    }
+    ResultStore copy = *set;
+    CommitResults(std::move(copy));
+    return true;
+}
+
+void MemoryTool::DeleteResultSet(const char* name) {
+    std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+    m_resultSets.erase(name);
+}
+
+void MemoryTool::GetResultSets(std::vector<std::pair<std::string, size_t>>& out) {
+    std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+    out.resize(m_resultSets.size());
+    size_t i = 0;
+    for (const auto& it : m_resultSets) {
+        out[i].first.assign(it.first); // Keeps the string's buffer when it fits
+        out[i].second = it.second->Size();
+        i++;
+    }
+}
+
+bool MemoryTool::CombineResultSet(int op, const char* name) {
+    std::shared_ptr<const ResultStore> set;
+    {
+        std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+        auto it = m_resultSets.find(name);
+        if (it == m_resultSets.end()) return false;
+        set = it->second;
+    }
+    auto startTime = std::chrono::steady_clock::now();
+
+    // Merging needs address order on both sides
+    std::shared_ptr<ResultStore> sorted;
+    if (!set->IsSorted()) {
+        sorted = std::make_shared<ResultStore>(*set);
+        sorted->Sort();
+        set = sorted;
+    }
+    if (!m_results.IsSorted()) {
+        ResultStore copy = m_results;
+        copy.Sort();
+        CommitResults(std::move(copy));
+    }
+
+    ResultStore combined;
+    std::vector<uint64_t> removed;
+    ResultStore::Combine(m_results, *set, op, combined, &removed);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+    printf("Combined %zu with '%s' (%zu): %zu results in %.1f ms\n", m_results.Size(), name, set->Size(), combined.Size(), ms);
+
+    if (op == SET_UNION) CommitResults(std::move(combined));
+    else CommitRefine(std::move(combined), std::move(removed), op == SET_INTERSECT ? "Intersect" : "Difference");
+    return true;
+}
+
+// ==============================================================================================
+// Persistence
+// ==============================================================================================
+
+TargetFingerprint MemoryTool::GetTargetFingerprint() {
+    TargetFingerprint fp;
+    int pid = getPID(m_pkgName.c_str());
+    if (pid <= 0) return fp;
+    fp.pid = pid;
+
+    // Field 22 of stat; the command name in field 2 may itself contain spaces and parentheses
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    std::ifstream stat(path);
+    std::string line;
+    if (std::getline(stat, line)) {
+        size_t close = line.rfind(')');
+        if (close != std::string::npos) {
+            std::istringstream fields(line.substr(close + 2));
+            std::string field;
+            for (int i = 3; i <= 22 && fields >> field; i++) {
+                if (i == 22) fp.startTime = strtoull(field.c_str(), nullptr, 10);
+            }
+        }
+    }
+
+    // Range and name of every writable map, the same lines readmaps looks at
+    uint64_t hash = 1469598103934665603ULL;
+    snprintf(path, sizeof(path), "/proc/%d/maps", pid);
+    std::ifstream maps(path);
+    while (std::getline(maps, line)) {
+        if (line.find("rw") == std::string::npos) continue;
+        size_t space = line.find(' ');
+        size_t name = line.find_first_of("/[", space);
+        std::string key = line.substr(0, space) + (name == std::string::npos ? "" : line.substr(name));
+        for (unsigned char c : key) {
+            hash ^= c;
+            hash *= 1099511628211ULL;
+        }
+    }
+    fp.mapsHash = hash;
+    return fp;
+}
+
+static int CompareFingerprint(const TargetFingerprint& saved, const TargetFingerprint& now) {
+    if (saved.pid != now.pid || saved.startTime != now.startTime) return FILE_LOAD_STALE;
+    if (saved.mapsHash != now.mapsHash) return FILE_LOAD_MAPS_CHANGED;
+    return FILE_LOAD_OK;
+}
+
+bool MemoryTool::SaveResultsFile(const char* path, const char* setName) {
+    std::shared_ptr<const ResultStore> set;
+    if (setName) {
+        std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+        auto it = m_resultSets.find(setName);
+        if (it == m_resultSets.end()) return false;
+        set = it->second;
+    }
+    // The job thread is the only writer of m_results, so a job can write it out unlocked
+    bool ok = (set ? *set : m_results).WriteFile(path, GetTargetFingerprint());
+    if (ok) printf("Saved %zu results to %s\n", (set ? *set : m_results).Size(), path);
+    return ok;
+}
+
+int MemoryTool::LoadResultsFile(const char* path, const char* setName, bool force) {
+    ResultStore store;
+    TargetFingerprint saved;
+    if (!store.MapFile(path, &saved)) {
+        printf("[Error] %s is not a readable result file\n", path);
+        return FILE_LOAD_BAD_FILE;
+    }
+    int status = CompareFingerprint(saved, GetTargetFingerprint());
+    if (status == FILE_LOAD_STALE && !force) {
+        printf("[Error] %s was saved from another process instance (pid %d), not loaded\n", path, saved.pid);
+        return status;
+    }
+    if (status == FILE_LOAD_MAPS_CHANGED) printf("[Warn] Target maps changed since %s was saved\n", path);
+
+    size_t rows = store.Size();
+    if (setName) {
+        std::shared_ptr<ResultStore> set = std::make_shared<ResultStore>();
+        set->Swap(store);
+        std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+        m_resultSets[setName] = set;
+    } else {
+        CommitResults(std::move(store));
+    }
+    printf("Loaded %zu results from %s\n", rows, path);
+    return status;
+}
+
+bool MemoryTool::SaveFreezeFile(const char* path) {
+    std::vector<FileFreezeItem> records;
+    {
+        std::lock_guard<std::mutex> lock(m_freezeMutex);
         for (const auto& item : m_freezeItems) {
-            WriteAddress(item.addr, item.value.c_str(), item.type);
+            FileFreezeItem rec;
+            memset(&rec, 0, sizeof(rec));
+            rec.addr = item.addr;
+            memcpy(rec.bytes, item.bytes, sizeof(rec.bytes));
+            rec.type = (uint32_t)item.type;
+            rec.periodUs = item.periodUs;
+            records.push_back(rec);
+        }
+    }
+
+    ResultFileHeader h{};
+    memcpy(h.magic, FREEZE_FILE_MAGIC, sizeof(h.magic));
+    h.version = RESULT_FILE_VERSION;
+    h.headerSize = sizeof(h);
+    h.rowCount = records.size();
+    h.addrsOffset = sizeof(h); // Already 8-byte aligned
+    h.fileSize = h.addrsOffset + records.size() * sizeof(FileFreezeItem);
+    h.target = GetTargetFingerprint();
+
+    std::string tmp = std::string(path) + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (!fp) return false;
+    bool ok = fwrite(&h, sizeof(h), 1, fp) == 1 &&
+              (records.empty() || fwrite(records.data(), sizeof(FileFreezeItem), records.size(), fp) == records.size());
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path) != 0) {
+        unlink(tmp.c_str());
+        return false;
+    }
+    printf("Saved %zu freeze items to %s\n", records.size(), path);
+    return true;
+}
+
+int MemoryTool::LoadFreezeFile(const char* path, bool force) {
+    std::ifstream file(path, std::ios::binary);
+    ResultFileHeader h;
+    if (!file.read((char*)&h, sizeof(h)) || memcmp(h.magic, FREEZE_FILE_MAGIC, sizeof(h.magic)) != 0 ||
+        h.version != RESULT_FILE_VERSION || h.headerSize != sizeof(h) || h.rowCount > (1 << 24)) {
+        printf("[Error] %s is not a readable freeze file\n", path);
+        return FILE_LOAD_BAD_FILE;
+    }
+    std::vector<FileFreezeItem> records((size_t)h.rowCount);
+    file.seekg((std::streamoff)h.addrsOffset);
+    if (!records.empty() && !file.read((char*)records.data(), records.size() * sizeof(FileFreezeItem))) {
+        printf("[Error] %s is truncated\n", path);
+        return FILE_LOAD_BAD_FILE;
+    }
+    int status = CompareFingerprint(h.target, GetTargetFingerprint());
+    if (status == FILE_LOAD_STALE && !force) {
+        printf("[Error] %s was saved from another process instance (pid %d), not loaded\n", path, h.target.pid);
+        return status;
+    }
+
+    std::vector<FreezeItem> items;
+    for (const auto& rec : records) {
+        FreezeItem item;
+        item.addr = rec.addr;
+        item.type = (int)rec.type;
+        item.periodUs = rec.periodUs;
+        item.size = (uint8_t)GetTypeInfo(item.type).size;
+        if (item.size == 0) continue;
+        memcpy(item.bytes, rec.bytes, sizeof(item.bytes));
+        char text[64];
+        FormatValue(item.bytes, item.type, text, sizeof(text));
+        item.value = text;
+        items.push_back(item);
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_freezeMutex);
+        m_freezeItems.swap(items);
+        m_freezeDirty = true;
+    }
+    printf("Loaded %zu freeze items from %s\n", m_freezeItems.size(), path);
+    return status;
+}
+
+// ==============================================================================================
+// Background Jobs
+// ==============================================================================================
+
+void MemoryTool::BeginProgress(uint64_t total) {
+    m_progress.bytesTotal = total;
+    m_progress.bytesDone = 0;
+    m_progress.hits = 0;
+}
+
+void MemoryTool::ClearResults() {
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    m_results.Clear();
+    m_resultsGen++;
+    m_history.clear();
+    m_historyPos = 0;
+}
+
+void MemoryTool::CommitResults(ResultStore&& results) {
+    // Readers (the overlay) hold m_resultsMutex while they walk m_results
+    std::lock_guard<std::mutex> lock(m_resultsMutex);
+    m_results.Swap(results);
+    m_resultsGen++;
+    m_history.clear();
+    m_history.emplace_back();
+    m_history[0].label = "Scan";
+    m_history[0].count = m_results.Size();
+    m_history[0].type = m_results.type;
+    m_historyPos = 0;
+}
+
+int MemoryTool::SubmitJob(const char* label, std::function<void()> work, std::function<void(const ScanJob&)> onDone) {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    if (!m_jobThread.joinable()) {
+        m_jobExit = false;
+        m_jobThread = std::thread(&MemoryTool::JobThreadLoop, this);
+    }
+    ScanJob job;
+    job.id = ++m_nextJobId;
+    job.label = label;
+    job.work = std::move(work);
+    job.onDone = std::move(onDone);
+    m_jobQueue.push_back(std::move(job));
+    m_jobCv.notify_one();
+    return m_nextJobId;
+}
+
+// Value strings are copied: the caller's buffers keep changing while the job waits
+int MemoryTool::SubmitSearch(const char* value, int type, std::function<void(const ScanJob&)> onDone) {
+    std::string val = value;
+    return SubmitJob("Scan", [this, val, type]() { MemorySearch(val.c_str(), type); }, std::move(onDone));
+}
+
+// The sink is shared with the caller, who reads it from onDone
+int MemoryTool::SubmitSearchTo(const char* label, const char* value, int type, std::shared_ptr<ResultSink> sink, std::function<void(const ScanJob&)> onDone) {
+    std::string val = value;
+    return SubmitJob(label, [this, val, type, sink]() { MemorySearch(val.c_str(), type, *sink); }, std::move(onDone));
+}
+
+int MemoryTool::SubmitRangeSearch(const char* from_value, const char* to_value, int type, std::function<void(const ScanJob&)> onDone) {
+    std::string from = from_value, to = to_value;
+    return SubmitJob("Range Scan", [this, from, to, type]() { RangeMemorySearch(from.c_str(), to.c_str(), type); }, std::move(onDone));
+}
+
+int MemoryTool::SubmitRefine(const char* value, long int offset, int type, std::function<void(const ScanJob&)> onDone) {
+    std::string val = value;
+    return SubmitJob("Refine", [this, val, offset, type]() { MemoryOffset(val.c_str(), offset, type); }, std::move(onDone));
+}
+
+int MemoryTool::SubmitCompare(int mode, const char* by, std::function<void(const ScanJob&)> onDone) {
+    std::string val = by ? by : "";
+    return SubmitJob("Compare", [this, mode, val]() { MemoryCompare(mode, val.c_str()); }, std::move(onDone));
+}
+
+int MemoryTool::SubmitCombine(int op, const char* name, std::function<void(const ScanJob&)> onDone) {
+    std::string setName = name;
+    return SubmitJob("Combine", [this, op, setName]() { CombineResultSet(op, setName.c_str()); }, std::move(onDone));
+}
+
+int MemoryTool::SubmitWrite(const char* value, long int offset, int type, std::function<void(const ScanJob&)> onDone) {
+    std::string val = value;
+    return SubmitJob("Write All", [this, val, offset, type]() { MemoryWrite(val.c_str(), offset, type); }, std::move(onDone));
+}
+
+int MemoryTool::SubmitResultView(const ViewQuery& query, std::function<void(const ScanJob&)> onDone) {
+    return SubmitJob("Sort", [this, query]() { BuildResultView(query); }, std::move(onDone));
+}
+
+void MemoryTool::CancelJobs() {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    for (auto& job : m_jobQueue) {
+        job.cancelled = true;
+        m_jobsDone.push_back(std::move(job));
+    }
+    m_jobQueue.clear();
+    if (m_runningJobId) m_progress.cancel = true; // Checked by the scan loops between chunks
+}
+
+bool MemoryTool::IsBusy() {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    return m_runningJobId != 0 || !m_jobQueue.empty();
+}
+
+ScanStats MemoryTool::GetLastScan() {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    return m_publishedScan;
+}
+
+void MemoryTool::GetTunedSizes(size_t& read, size_t& slice) {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    read = m_publishedRead;
+    slice = m_publishedSlice;
+}
+
+void MemoryTool::GetRunningJobLabel(char* out, size_t size) {
+    std::lock_guard<std::mutex> lock(m_jobMutex);
+    snprintf(out, size, "%s", m_runningJobLabel.c_str());
+}
+
+int MemoryTool::PollJobs() {
+    std::vector<ScanJob> done;
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        done.swap(m_jobsDone);
+    }
+    for (auto& job : done) {
+        if (job.onDone) job.onDone(job);
+    }
+    return (int)done.size();
+}
+
+void MemoryTool::StopJobs() {
+    CancelJobs();
+    {
+        std::lock_guard<std::mutex> lock(m_jobMutex);
+        m_jobExit = true;
+        m_jobCv.notify_all();
+    }
+    if (m_jobThread.joinable()) m_jobThread.join();
+}
+
+void MemoryTool::SetChangeListener(std::function<void(int)> listener) {
+    m_changeListener = listener;
+    m_valueCache.SetListener([listener]() { if (listener) listener(EVENT_VALUES); });
+}
+
+void MemoryTool::JobThreadLoop() {
+    std::unique_lock<std::mutex> lock(m_jobMutex);
+    while (true) {
+        m_jobCv.wait(lock, [this]() { return m_jobExit || !m_jobQueue.empty(); });
+        if (m_jobExit) break;
+
+        ScanJob job = std::move(m_jobQueue.front());
+        m_jobQueue.pop_front();
+        m_runningJobId = job.id;
+        m_runningJobLabel = job.label;
+        m_progress.cancel = false;
+        BeginProgress(0);
+        lock.unlock();
+
+        job.work();
+        m_scanHeapBytes = 0;
+        EnforceMemoryBudget();
+        m_resultCount = m_results.Size(); // Only this thread replaces m_results
+
+        lock.lock();
+        m_publishedScan = m_lastScan;
+        m_publishedRead = ChunkTuner::SizeOf(m_tuner.read.home);
+        m_publishedSlice = ChunkTuner::SizeOf(m_tuner.slice.home);
+        job.cancelled = m_progress.cancel;
+        m_progress.cancel = false;
+        m_runningJobId = 0;
+        m_runningJobLabel.clear();
+        m_jobsDone.push_back(std::move(job));
+        NotifyChange(EVENT_JOB);
+    }
+}
+
+// ==============================================================================================
+// Memory Budget
+// ==============================================================================================
+
+// Only the tool's own data is counted: the binary, ImGui and driver buffers are small and fixed
+MemoryUsage MemoryTool::MeasureMemory() {
+    MemoryUsage usage;
+    usage.budget = m_memoryBudget;
+    {
+        std::lock_guard<std::mutex> lock(m_resultsMutex);
+        usage.results = m_results.HeapBytes();
+        usage.spilled += m_results.MappedBytes();
+        for (const auto& level : m_history) {
+            usage.history += level.removed.capacity() * sizeof(uint64_t);
+            if (level.snapshot) {
+                usage.history += level.snapshot->HeapBytes();
+                usage.spilled += level.snapshot->MappedBytes();
+            }
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+        for (const auto& it : m_resultSets) {
+            usage.savedSets += it.second->HeapBytes();
+            usage.spilled += it.second->MappedBytes();
         }
-        std::this_thread::sleep_for(std::chrono::microseconds(m_freezeDelay));
     }
+    for (const auto& it : m_pageCache.ranges) {
+        const PageHashCache::Range& range = it.second;
+        usage.pageCache += range.hashes.capacity() * sizeof(uint64_t) + range.hitStart.capacity() * sizeof(uint32_t) +
+                           range.hits.capacity() * sizeof(uint16_t);
+    }
+    usage.scratch = m_arena.Stats().bytesMapped;
+    return usage;
+}
+
+std::string MemoryTool::NextSpillPath() {
+    return m_spillDir + "/memtool_spill_" + std::to_string(getpid()) + "_" + std::to_string(m_spillSeq++);
+}
+
+void MemoryTool::PrepareStoreSink(StoreSink& sink) {
+    sink.heapBytes = &m_scanHeapBytes;
+    const uint64_t budget = m_memoryBudget;
+    if (!budget) return;
+    // The scan gets what everything else leaves, but never so little that it spills every few batches
+    const uint64_t MIN_SCAN_BYTES = 16 * 1024 * 1024;
+    uint64_t used = MeasureMemory().Total();
+    sink.spillBytes = used + MIN_SCAN_BYTES < budget ? budget - used : MIN_SCAN_BYTES;
+    sink.spillPath = NextSpillPath();
+}
+
+// Runs on the job thread, which is the only one that changes result stores, so stores are read
+// and written to files without m_resultsMutex; only swapping the spilled copy in takes it.
+void MemoryTool::EnforceMemoryBudget() {
+    const uint64_t budget = m_memoryBudget;
+    MemoryUsage usage = MeasureMemory();
+    auto over = [&]() {
+        usage = MeasureMemory();
+        return budget && usage.Total() > budget;
+    };
+    if (over()) {
+        printf("Memory: %.1f MB used of a %.1f MB budget, shedding\n", usage.Total() / 1048576.0, budget / 1048576.0);
+        // Cheapest to lose first: free scratch blocks, then the page hash cache (the next rescan
+        // compares every page again)
+        m_arena.Trim();
+        if (over()) m_pageCache = PageHashCache();
+
+        // Then result stores go to files, largest first; m_results last, the overlay reads it most
+        struct Victim {
+            uint64_t bytes;
+            size_t level;     // History level, or SIZE_MAX
+            std::string set;  // Saved set name, or empty
+        };
+        std::vector<Victim> victims;
+        {
+            std::lock_guard<std::mutex> lock(m_resultsMutex);
+            for (size_t l = 0; l < m_history.size(); l++) {
+                if (m_history[l].snapshot) victims.push_back({ m_history[l].snapshot->HeapBytes(), l, "" });
+            }
+        }
+        {
+            std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+            for (const auto& it : m_resultSets) victims.push_back({ it.second->HeapBytes(), SIZE_MAX, it.first });
+        }
+        std::sort(victims.begin(), victims.end(), [](const Victim& a, const Victim& b) { return a.bytes > b.bytes; });
+        victims.push_back({ 0, SIZE_MAX, "" }); // m_results
+
+        for (const Victim& victim : victims) {
+            if (!over()) break;
+            std::string path = NextSpillPath();
+            ResultStore mapped;
+            if (victim.level != SIZE_MAX) {
+                ResultStore* snapshot = m_history[victim.level].snapshot.get();
+                if (snapshot->IsMapped() || !snapshot->SpillTo(path.c_str(), mapped)) continue;
+                std::lock_guard<std::mutex> lock(m_resultsMutex);
+                snapshot->Swap(mapped);
+            } else if (!victim.set.empty()) {
+                std::shared_ptr<const ResultStore> set;
+                {
+                    std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+                    auto it = m_resultSets.find(victim.set);
+                    if (it != m_resultSets.end()) set = it->second;
+                }
+                if (!set || set->IsMapped() || !set->SpillTo(path.c_str(), mapped)) continue;
+                std::lock_guard<std::mutex> lock(m_resultSetsMutex);
+                auto it = m_resultSets.find(victim.set);
+                if (it != m_resultSets.end() && it->second == set) it->second = std::make_shared<ResultStore>(std::move(mapped));
+            } else {
+                if (m_results.IsMapped() || !m_results.SpillTo(path.c_str(), mapped)) continue;
+                std::lock_guard<std::mutex> lock(m_resultsMutex);
+                m_results.Swap(mapped);
+            }
+        }
+        over();
+        printf("Memory: %.1f MB after shedding, %.1f MB of results spilled to %s\n", usage.Total() / 1048576.0,
+               usage.spilled / 1048576.0, m_spillDir.c_str());
+    }
+    std::lock_guard<std::mutex> lock(m_memoryMutex);
+    m_memoryUsage = usage;
+}
+
+MemoryUsage MemoryTool::GetMemoryUsage() {
+    MemoryUsage usage;
+    {
+        std::lock_guard<std::mutex> lock(m_memoryMutex);
+        usage = m_memoryUsage;
+    }
+    usage.budget = m_memoryBudget;
+    usage.scanning = m_scanHeapBytes;
+    usage.scratch = m_arena.Stats().bytesMapped;
+    // Called every frame: one pread of a descriptor kept open, no stdio buffer to allocate
+    static int statm = open("/proc/self/statm", O_RDONLY | O_CLOEXEC);
+    char text[128];
+    ssize_t got = statm >= 0 ? pread(statm, text, sizeof(text) - 1, 0) : -1;
+    if (got > 0) {
+        text[got] = '\0';
+        unsigned long size = 0, resident = 0;
+        if (sscanf(text, "%lu %lu", &size, &resident) == 2) usage.processRss = (uint64_t)resident * (uint64_t)sysconf(_SC_PAGESIZE);
+    }
+    return usage;
 }
 
 // ==============================================================================================
@@ -6,7 +6,17 @@
 #include <memory>
 #include <thread>
 #include <mutex>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <condition_variable>
+#include <unordered_map>
+#include <map>
+#include <type_traits>
+#include <algorithm>
 #include "kpm_client.hpp"
+#include "ScanKernels.h"
+#include "ResultFile.h"
 
 // Modern Types
 using ADDRESS = uint64_t;
@@ -25,16 +35,772 @@ struct MemoryMap {
     // No 'next' pointer, use vector
 };
 
-struct MemoryResult {
-    ADDRESS addr;
-    int type; // TYPE_DWORD, etc.
-    std::string mapName; // Holds the memory range name (e.g. [anon:libc_malloc])
+// Columnar result set. Rows are addresses in ascending order; the map each row came from is
+// kept as runs over a small name table, so a hit costs 8 bytes instead of a struct with a string.
+// An optional value column holds the value each row had at the last scan or refine, packed at
+// the type's width, for compare-to-previous refines.
+// Results of an AUTO scan have type TYPE_AUTO and a type mask column: bit (1 << DataType) per
+// type the row matched as.
+// A store loaded from a file views the file's columns in place; the first change copies them.
+class ResultStore {
+public:
+    int type = 0; // TYPE_DWORD, etc., shared by all rows
+
+    size_t Size() const { return m_view ? m_viewRows : m_addrs.size(); }
+    bool Empty() const { return Size() == 0; }
+    ADDRESS Addr(size_t i) const { return Addrs()[i]; }
+    const ADDRESS* Addrs() const { return m_view ? m_viewAddrs : m_addrs.data(); }
+    const std::string& RegionName(size_t i) const; // Map name, e.g. [anon:libc_malloc]
+    size_t LowerBound(ADDRESS addr) const; // First row at or above addr, Size() if none
+
+    // Runs of consecutive rows from the same map, in row order
+    size_t RegionRunCount() const { return m_runs.size(); }
+    size_t RegionRunFirstRow(size_t run) const { return m_runs[run].firstRow; }
+    const std::string& RegionRunName(size_t run) const { return m_regions[m_runs[run].region]; }
+
+    bool HasValues() const { return m_valueWidth != 0; }
+    uint32_t ValueWidth() const { return m_valueWidth; }
+    const uint8_t* Value(size_t i) const { return Values() + i * m_valueWidth; }
+    const uint8_t* Values() const { return m_view ? m_viewValues : m_values.data(); }
+    void EnableValues(uint32_t width); // Starts an empty column; rows appended later must append values too
+    void DropValues();
+    void AppendValues(const uint8_t* packed, size_t count);
+    void SetValues(std::vector<uint8_t>&& packed, uint32_t width); // One value per existing row
+
+    bool HasTypeMasks() const { return m_hasTypeMasks; }
+    uint8_t TypeMask(size_t i) const { return TypeMasks()[i]; }
+    const uint8_t* TypeMasks() const { return m_view ? m_viewTypeMasks : m_typeMasks.data(); }
+    int RowType(size_t i) const { return m_hasTypeMasks && TypeMask(i) ? __builtin_ctz(TypeMask(i)) : type; } // First matched type
+    void EnableTypeMasks(); // Starts an empty column, like EnableValues
+    void AppendTypeMasks(const uint8_t* masks, size_t count);
+
+    void Clear();
+    void Reserve(size_t rows) { Materialize(); m_addrs.reserve(rows); }
+    void Swap(ResultStore& other);
+
+    // Appends hits from one map; addresses must continue the ascending order
+    void Append(const ADDRESS* addrs, size_t count, const std::string& region);
+    // Appends the given rows of 'src' (ascending row indices) with their regions. With a type mask
+    // column, 'masks' (one per appended row) replaces the masks of 'src'.
+    void AppendRows(const ResultStore& src, const uint32_t* rows, size_t count, const uint8_t* masks = nullptr);
+    // Appends the rows of 'src' whose bit in 'removed' is clear, values included
+    void AppendKept(const ResultStore& src, const uint64_t* removed);
+
+    bool IsSorted() const;
+    void Sort();
+
+    // out = a op b (SetOp) by sort-merge, split by address range across threads for large inputs.
+    // Rows and regions come from whichever input holds them; for intersection / difference, which
+    // are subsets of 'a', 'removed' receives the history bitmap over a's rows.
+    static void Combine(const ResultStore& a, const ResultStore& b, int op, ResultStore& out, std::vector<uint64_t>* removed = nullptr);
+
+    // File format in ResultFile.h. Writes go to a temporary file renamed into place.
+    bool WriteFile(const char* path, const TargetFingerprint& target) const;
+    // Writes the rows of 'parts' in order as one file. They must share the type and columns, and
+    // addresses must keep ascending from one part to the next.
+    static bool WriteFile(const char* path, const ResultStore* const* parts, size_t count, const TargetFingerprint& target);
+    bool MapFile(const char* path, TargetFingerprint* target); // Replaces the contents on success
+    bool IsMapped() const { return m_view != nullptr; }
+
+    // Memory budget: heap held by the columns and region table, and the bytes viewed from a file.
+    // Spill moves the rows to a file at 'path' and views them from there; the file is unlinked at
+    // once, so it lives exactly as long as the mapping. Appending brings the rows back to the heap.
+    size_t HeapBytes() const;
+    size_t MappedBytes() const { return m_view ? m_view->length : 0; }
+    bool Spill(const char* path);
+    bool SpillTo(const char* path, ResultStore& out) const; // Leaves this one alone, for shared stores
+
+private:
+    struct RegionRun {
+        size_t firstRow;
+        uint32_t region; // Index into m_regions
+    };
+    std::vector<ADDRESS> m_addrs;
+    std::vector<uint8_t> m_values;
+    uint32_t m_valueWidth = 0;
+    std::vector<uint8_t> m_typeMasks;
+    bool m_hasTypeMasks = false;
+    std::vector<RegionRun> m_runs;
+    std::vector<std::string> m_regions;
+    std::unordered_map<std::string, uint32_t> m_regionIndex;
+
+    // Columns viewed in place from a mapped file, instead of m_addrs / m_values
+    std::shared_ptr<const MappedFile> m_view;
+    const ADDRESS* m_viewAddrs = nullptr;
+    const uint8_t* m_viewValues = nullptr;
+    const uint8_t* m_viewTypeMasks = nullptr;
+    size_t m_viewRows = 0;
+    void Materialize(); // Copies viewed columns into the vectors and drops the view
+
+    size_t RunOf(size_t row) const;
+    uint32_t InternRegion(const std::string& name);
+    uint8_t MaskOf(size_t row) const; // The row's mask, or the store type's bit without a mask column
+};
+
+// Operators for combining result sets
+enum SetOp {
+    SET_INTERSECT,  // In both
+    SET_UNION,      // In either
+    SET_DIFFERENCE, // In the current set but not the other
+};
+
+// Orders of a result view
+enum SortKey {
+    SORT_ADDRESS, // Scan order
+    SORT_VALUE,   // Current value, compared as numbers across AUTO rows' types
+    SORT_REGION,  // Map name, then address
+    SORT_CHANGES, // Times the value changed between view builds
+};
+
+// What a result view shows and in which order
+struct ViewQuery {
+    int sortKey = SORT_ADDRESS;
+    bool descending = false;
+    std::string regionFilter;  // Substring of the map name, empty = any
+    bool valueFilter = false;  // Keep rows whose current value is in [valueMin, valueMax]
+    double valueMin = 0;
+    double valueMax = 0;
+    ADDRESS addrMin = 0;
+    ADDRESS addrMax = ~(ADDRESS)0;
+};
+
+// A filtered, sorted index over m_results, built on the job thread. It belongs to the
+// results generation it was built from and is ignored once those rows are replaced.
+struct ResultView {
+    ViewQuery query;
+    std::vector<uint32_t> rows;    // Rows of m_results in display order
+    uint64_t generation = 0;
+    bool readValues = false;       // Values were read fresh for this build, so change counts moved
+    double buildMs = 0;
+};
+
+// One step of refine history. Levels are stored as deltas: a bit per parent row saying whether
+// the refine dropped it. The levels next to the current one also keep their rows materialized so
+// a single undo / redo is a swap.
+struct HistoryLevel {
+    std::string label;
+    size_t count = 0;
+    int type = 0;                          // Of the level's rows: refining AUTO results as one type narrows it
+    std::vector<uint64_t> removed;         // Over the parent's rows, empty for the root (a scan)
+    std::unique_ptr<ResultStore> snapshot; // Null for the current level (it lives in m_results) or once evicted
+};
+
+// Receives scan matches in batches instead of having them collected into m_results.
+// A batch holds ascending addresses that all lie in 'map'.
+class ResultSink {
+public:
+    virtual ~ResultSink() = default;
+    virtual void Begin(int /*type*/) {}
+    virtual bool Consume(const ADDRESS* addrs, size_t count, const MemoryMap& map) = 0; // false stops the scan
+    // AUTO scans: one DataType bit mask per hit, for the types it matched as
+    virtual bool ConsumeTyped(const ADDRESS* addrs, const uint8_t* /*typeMasks*/, size_t count, const MemoryMap& map) {
+        return Consume(addrs, count, map);
+    }
+    virtual void End(bool /*cancelled*/) {}
+};
+
+// Counts hits, constant memory
+class CountSink : public ResultSink {
+public:
+    size_t count = 0;
+    void Begin(int /*type*/) override { count = 0; }
+    bool Consume(const ADDRESS* /*addrs*/, size_t n, const MemoryMap& /*map*/) override { count += n; return true; }
+};
+
+// Collects hits into its own ResultStore. With a spill limit, the store moves to a file each
+// time its heap passes the limit and the scan carries on in an empty one; End joins the parts
+// into one file-backed store.
+class StoreSink : public ResultSink {
+public:
+    ResultStore store;
+    size_t spillBytes = 0;                      // 0 = never spill
+    std::string spillPath;                      // Part files are spillPath.N
+    std::atomic<uint64_t>* heapBytes = nullptr; // Updated per batch, for the memory display
+    void Begin(int type) override;
+    bool Consume(const ADDRESS* addrs, size_t n, const MemoryMap& map) override;
+    bool ConsumeTyped(const ADDRESS* addrs, const uint8_t* typeMasks, size_t n, const MemoryMap& map) override;
+    void End(bool cancelled) override;
+    bool Spilled() const { return m_spills != 0; }
+
+private:
+    void Spill();
+    std::vector<ResultStore> m_parts; // Spilled so far, in scan order
+    size_t m_spills = 0;
+};
+
+// Writes a value at hit + offset as hits arrive
+class WriteSink : public ResultSink {
+public:
+    size_t written = 0;
+    WriteSink(KPMClient& kpm, const char* value, int type, long int offset = 0);
+    bool Consume(const ADDRESS* addrs, size_t n, const MemoryMap& map) override;
+
+private:
+    KPMClient& m_kpm;
+    uint8_t m_bytes[8];
+    size_t m_size;
+    long int m_offset;
+};
+
+class MemoryTool;
+
+// Adds a freeze item at hit + offset for every hit
+class FreezeSink : public ResultSink {
+public:
+    size_t added = 0;
+    FreezeSink(MemoryTool& tool, const char* value, int type, long int offset = 0, int periodUs = 0);
+    bool Consume(const ADDRESS* addrs, size_t n, const MemoryMap& map) override;
+
+private:
+    MemoryTool& m_tool;
+    std::string m_value;
+    int m_type;
+    long int m_offset;
+    int m_periodUs;
+};
+
+// Forwards batches to a function
+class CallbackSink : public ResultSink {
+public:
+    typedef std::function<bool(const ADDRESS* addrs, size_t count, const MemoryMap& map)> Callback;
+    explicit CallbackSink(Callback fn) : m_fn(std::move(fn)) {}
+    bool Consume(const ADDRESS* addrs, size_t n, const MemoryMap& map) override { return m_fn(addrs, n, map); }
+
+private:
+    Callback m_fn;
 };
 
 struct FreezeItem {
     ADDRESS addr;
     std::string value; // Stored as string to handle all types simply
     int type;
+    int periodUs = 0; // Rewrite period, 0 = follow m_freezeDelay
+    uint8_t bytes[8] = {}; // Target value encoded once, written as raw bytes
+    uint8_t size = 0;
+    uint64_t overwrites = 0; // Ticks where the target had changed the value (compare mode)
+};
+
+// Batched reads: fields sorted by address are coalesced into spans so one
+// syscall covers many of them. Gaps are kept below a page so a span never
+// touches a page that does not hold a field.
+struct ReadSpan {
+    ADDRESS addr;
+    uint32_t len;
+    uint32_t first; // Index of the first field in this span
+    uint32_t count;
+    uint32_t bufOffset; // Where the span lands in the caller's buffer
+};
+
+static const size_t SPAN_MAX_GAP = 512;
+static const size_t SPAN_MAX_LEN = 64 * 1024;
+
+template <typename AddrOf, typename SizeOf>
+std::vector<ReadSpan> BuildReadSpans(size_t count, AddrOf addrOf, SizeOf sizeOf) {
+    std::vector<ReadSpan> spans;
+    uint32_t bufOffset = 0;
+    for (size_t i = 0; i < count; i++) {
+        ADDRESS a = addrOf(i);
+        ADDRESS e = a + sizeOf(i);
+        if (!spans.empty()) {
+            ReadSpan& s = spans.back();
+            ADDRESS spanEnd = s.addr + s.len;
+            if (a <= spanEnd + SPAN_MAX_GAP && e - s.addr <= SPAN_MAX_LEN) {
+                if (e > spanEnd) {
+                    bufOffset += (uint32_t)(e - spanEnd);
+                    s.len = (uint32_t)(e - s.addr);
+                }
+                s.count++;
+                continue;
+            }
+        }
+        spans.push_back({a, (uint32_t)(e - a), (uint32_t)i, 1, bufOffset});
+        bufOffset += (uint32_t)(e - a);
+    }
+    return spans;
+}
+
+// Published by the freeze scheduler, one entry per distinct period
+struct FreezeStats {
+    int periodUs;
+    size_t itemCount;
+    uint64_t ticks;
+    uint64_t overruns;       // Deadlines skipped because the writes ran past them
+    double achievedPeriodUs; // Mean interval between actual rewrites
+    double jitterP50Us;      // Lateness against the absolute deadline
+    double jitterP99Us;
+    double jitterMaxUs;
+};
+
+// Overwriting single-producer ring of timestamped samples. The sampler pushes; any number of
+// readers copy out the newest samples without a lock and drop those the writer lapped meanwhile.
+class SampleRing {
+public:
+    static const size_t CAPACITY = 4096; // Power of two; four seconds at 1 kHz
+
+    void Push(int64_t timeNs, double value) {
+        uint64_t head = m_head.load(std::memory_order_relaxed);
+        // Claim the slot first: a reader that sees any of the new data also sees the claim
+        m_claim.store(head + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        Slot& slot = m_slots[head & (CAPACITY - 1)];
+        uint64_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        slot.timeNs.store(timeNs, std::memory_order_relaxed);
+        slot.value.store(bits, std::memory_order_relaxed);
+        m_head.store(head + 1, std::memory_order_release);
+    }
+
+    // Copies up to 'max' of the newest samples, oldest first; returns how many
+    size_t Read(int64_t* timesNs, double* values, size_t max) const {
+        uint64_t head = m_head.load(std::memory_order_acquire);
+        uint64_t n = std::min<uint64_t>(std::min<uint64_t>(head, max), CAPACITY);
+        uint64_t first = head - n;
+        for (uint64_t i = first; i < head; i++) {
+            const Slot& slot = m_slots[i & (CAPACITY - 1)];
+            timesNs[i - first] = slot.timeNs.load(std::memory_order_relaxed);
+            uint64_t bits = slot.value.load(std::memory_order_relaxed);
+            memcpy(&values[i - first], &bits, sizeof(bits));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        // Samples the writer may have started to overwrite while we copied are not valid
+        uint64_t claim = m_claim.load(std::memory_order_relaxed);
+        uint64_t valid = claim > CAPACITY ? claim - CAPACITY : 0;
+        if (first >= valid) return (size_t)n;
+        uint64_t drop = std::min<uint64_t>(valid - first, n);
+        memmove(timesNs, timesNs + drop, (size_t)(n - drop) * sizeof(*timesNs));
+        memmove(values, values + drop, (size_t)(n - drop) * sizeof(*values));
+        return (size_t)(n - drop);
+    }
+
+    uint64_t Count() const { return m_head.load(std::memory_order_acquire); }
+
+private:
+    struct Slot {
+        std::atomic<int64_t> timeNs{0};
+        std::atomic<uint64_t> value{0}; // double bits
+    };
+    Slot m_slots[CAPACITY];
+    std::atomic<uint64_t> m_head{0};  // Samples published
+    std::atomic<uint64_t> m_claim{0}; // Samples being or been written
+};
+
+// An address on the watch list. Shared between the list, the sampler and the overlay, so a
+// removed item stays valid for whoever still holds it.
+struct WatchItem {
+    ADDRESS addr = 0;
+    int type = 0;
+    std::atomic<uint64_t> failedReads{0};
+    SampleRing samples;
+};
+
+// Published by the watch sampler
+struct WatchStats {
+    size_t items = 0;
+    size_t spans = 0;          // Reads per sample round
+    size_t pages = 0;          // Distinct pages the items lie in
+    int rateHz = 0;            // Asked for
+    double achievedHz = 0;
+    double roundUs = 0;        // Mean time to read and record one round
+    uint64_t missedRounds = 0; // Deadlines skipped because a round ran past them
+};
+
+// Static description of a DataType
+struct TypeInfo {
+    const char* name;
+    uint32_t size;
+    bool isFloat;
+    bool isSigned;
+};
+
+// Where a pipelined scan waited: readers on a full ring (compare is the bottleneck), the
+// compare loop on an empty one (reads are)
+struct PipelineStats {
+    uint32_t depth = 0;   // Chunks in flight, 1 = no pipeline
+    uint32_t readers = 0; // Reader threads, 0 = the scan thread reads
+    uint64_t chunks = 0;
+    uint64_t shortReads = 0; // Chunks that read back short: they ran into an unreadable page
+    uint64_t readerStalls = 0;
+    uint64_t compareStalls = 0;
+    double readerWaitMs = 0;
+    double compareWaitMs = 0;
+};
+
+// Counters of the most recent search, for the console and the overlay
+struct ScanStats {
+    size_t results = 0;
+    uint64_t driverCalls = 0;
+    uint64_t resumptions = 0; // Times a slice overflowed its result cap and was resumed
+    uint64_t pagesReused = 0; // User-side scans: pages whose hits came from the page hash cache
+    uint64_t pagesTotal = 0;
+    PipelineStats pipeline;   // User-side scans
+    uint64_t minorFaults = 0; // Page faults of the whole process during the scan, reader threads included
+    uint64_t majorFaults = 0;
+    uint64_t scratchAcquires = 0; // Scan arena buffers taken, and how many of them were reused
+    uint64_t scratchReuses = 0;
+    double elapsedMs = 0;
+};
+
+// Scan arena counters
+struct ArenaStats {
+    uint64_t bytesMapped = 0; // Blocks in use plus free ones
+    uint64_t bytesFree = 0;
+    uint64_t bytesLocked = 0;
+    uint64_t acquires = 0;
+    uint64_t reuses = 0;       // Acquires served from a free block
+    uint64_t lockFailures = 0; // mlock refused (RLIMIT_MEMLOCK); the block stays unlocked
+};
+
+// Scratch memory for scans and their reader threads: page-aligned mmap blocks, advised for
+// transparent huge pages from HUGE_PAGE up and optionally mlocked. A released block goes on a
+// free list for the next scan, so rescans work in memory that is already faulted in instead
+// of mapping and zeroing fresh pages every time.
+class ScanArena {
+public:
+    static const size_t HUGE_PAGE = 2 * 1024 * 1024;
+    static const size_t MAX_FREE_BYTES = 64 * 1024 * 1024; // Free blocks beyond this are unmapped
+
+    // A lease on one block viewed as 'count' Ts, handed back when it goes away. The contents
+    // are not cleared: a reused block holds whatever its last user left.
+    template <typename T>
+    class Array {
+    public:
+        Array() = default;
+        Array(Array&& other) noexcept { *this = std::move(other); }
+        Array& operator=(Array&& other) noexcept {
+            if (this != &other) {
+                Reset();
+                m_arena = other.m_arena;
+                m_data = other.m_data;
+                m_block = other.m_block;
+                m_count = other.m_count;
+                other.m_arena = nullptr;
+                other.m_data = nullptr;
+                other.m_count = 0;
+            }
+            return *this;
+        }
+        ~Array() { Reset(); }
+
+        T* data() { return m_data; }
+        const T* data() const { return m_data; }
+        size_t size() const { return m_count; }
+        T& operator[](size_t i) { return m_data[i]; }
+        const T& operator[](size_t i) const { return m_data[i]; }
+        void Reset() {
+            if (m_arena) m_arena->Release(m_data, m_block);
+            m_arena = nullptr;
+            m_data = nullptr;
+            m_count = 0;
+        }
+
+    private:
+        friend class ScanArena;
+        ScanArena* m_arena = nullptr;
+        T* m_data = nullptr;
+        size_t m_block = 0; // Bytes
+        size_t m_count = 0;
+    };
+
+    ScanArena() = default;
+    ~ScanArena(); // Unmaps every block; no lease may outlive the arena
+    ScanArena(const ScanArena&) = delete;
+    ScanArena& operator=(const ScanArena&) = delete;
+
+    // Throws std::bad_alloc when the kernel refuses the mapping, like the vectors it replaces
+    template <typename T>
+    Array<T> Acquire(size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "Arena memory is never constructed");
+        Array<T> array;
+        array.m_data = (T*)Take(count * sizeof(T), array.m_block);
+        array.m_arena = this;
+        array.m_count = count;
+        return array;
+    }
+
+    void SetLocked(bool locked); // mlock blocks from now on; free blocks of the old kind are dropped
+    bool IsLocked();
+    void Trim();                 // Unmaps the free blocks
+    ArenaStats Stats();
+
+private:
+    void* Take(size_t bytes, size_t& block);
+    void Release(void* base, size_t block);
+    void Unmap(void* base, size_t block);
+
+    std::mutex m_mutex;
+    struct BlockInfo {
+        bool wantLocked; // m_locked when it was mapped
+        bool locked;     // mlock succeeded
+    };
+    std::multimap<size_t, void*> m_free; // Free blocks by size
+    std::unordered_map<void*, BlockInfo> m_blocks; // Every mapped block
+    bool m_locked = false;
+    ArenaStats m_stats;
+};
+
+// What an access trace watches for
+enum TraceKind {
+    TRACE_WRITES = 0,
+    TRACE_ACCESSES = 1, // Reads and writes: x86 has no read-only watchpoints
+};
+
+// One instruction seen touching a traced address
+struct AccessSite {
+    ADDRESS pc = 0;
+    uint64_t hits = 0;
+    uint32_t threads = 0; // Distinct threads it hit on
+    std::string module;   // Mapping the pc lies in, empty if none
+    uint64_t offset = 0;  // pc as an offset into the module's file
+};
+
+// Access trace counters
+struct TraceStats {
+    size_t threads = 0;        // Threads with an armed breakpoint
+    uint64_t armFailures = 0;  // perf_event_open refusals, e.g. all debug registers taken
+    uint64_t samples = 0;
+    uint64_t lost = 0;         // Samples the kernel dropped on a full ring
+    uint64_t throttles = 0;    // Times the kernel throttled an event for hitting too often
+};
+
+// "What accesses this address": a hardware watchpoint (perf_event_open PERF_TYPE_BREAKPOINT) on
+// every thread of the target. Each hit is a sample in the thread's mmap'd perf ring, which a
+// collector thread drains; the target only pays the debug exception, never a ptrace stop.
+// Threads started later are armed on the next sweep of /proc/<pid>/task. On x86 the reported pc
+// is the instruction after the access, on arm64 the access itself.
+class AccessTracer {
+public:
+    AccessTracer() = default;
+    ~AccessTracer() { Stop(); }
+    AccessTracer(const AccessTracer&) = delete;
+    AccessTracer& operator=(const AccessTracer&) = delete;
+
+    // Replaces any running trace. 'len' of 1, 2, 4 or 8 bytes; an unaligned range is widened to
+    // its aligned 8 bytes. Fails with LastError() set when no thread could be armed.
+    bool Start(int pid, ADDRESS addr, size_t len, int kind);
+    void Stop();
+    bool IsRunning() const { return m_running; }
+    ADDRESS Address() const { return m_addr; }
+    int Kind() const { return m_kind; }
+    void LastError(char* out, size_t size); // "" when none
+
+    // Most hits first; new pcs are resolved against the target's maps. Fills 'out' in place so
+    // that a caller polling it each frame keeps its strings' storage.
+    void Sites(std::vector<AccessSite>& out);
+    TraceStats Stats();
+    void ClearSites();
+
+private:
+    struct Ring {
+        int fd = -1;
+        void* base = nullptr; // Metadata page followed by RING_PAGES of data
+    };
+    static const size_t RING_PAGES = 4; // Power of two; 16K holds ~680 samples between drains
+
+    bool Arm(int tid);
+    void Disarm(Ring& ring);
+    void Sweep();   // Arms new threads, drops exited ones
+    void Drain(Ring& ring);
+    void CollectLoop();
+
+    int m_pid = 0;
+    ADDRESS m_addr = 0;
+    uint64_t m_bpAddr = 0;
+    uint64_t m_bpLen = 0;
+    int m_kind = TRACE_WRITES;
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    std::map<int, Ring> m_rings;   // By tid, collector thread only once started
+
+    std::mutex m_mutex;            // Guards what follows
+    struct Site {
+        uint64_t hits = 0;
+        std::vector<int> tids;     // Distinct, usually one or two
+    };
+    std::unordered_map<uint64_t, Site> m_sites;
+    std::unordered_map<uint64_t, std::pair<std::string, uint64_t>> m_resolved; // pc -> module, offset
+    TraceStats m_stats;
+    std::string m_error;
+};
+
+// Formatted values of the rows the overlay is showing, kept fresh by a worker thread so that
+// drawing a table costs no reads. The overlay names its rows every frame; the worker reads them
+// as coalesced spans at Rate() Hz, or at once when the rows change, and publishes the text under
+// a seqlock that readers copy out of without ever blocking it.
+class ValueCache {
+public:
+    static const size_t MAX_ROWS = 512;
+    static const int MAX_RATE = 120;
+    struct Value {
+        ADDRESS addr;
+        int32_t type;
+        int32_t valid; // 0 when the read failed
+        char text[40];
+    };
+
+    explicit ValueCache(KPMClient& kpm) : m_kpm(kpm) {}
+    ~ValueCache() { Stop(); }
+    ValueCache(const ValueCache&) = delete;
+    ValueCache& operator=(const ValueCache&) = delete;
+
+    // Rows past MAX_ROWS are ignored. Cheap when they are the same as last time; starts the worker.
+    void SetRows(const ADDRESS* addrs, const int* types, size_t count);
+    // Copies the latest values, sorted by address then type; returns how many
+    size_t Read(Value* out, size_t max) const;
+    static const Value* Find(const Value* values, size_t count, ADDRESS addr, int type);
+    void SetRate(int hz);
+    int Rate() const { return m_rateHz; }
+    // Called from the worker after a round whose text differs from the last. Set before SetRows.
+    void SetListener(std::function<void()> listener) { m_listener = std::move(listener); }
+    double RoundUs() const { return m_roundNs / 1000.0; } // Read and format time of the last round
+    void Stop();
+
+private:
+    static const size_t WORDS = sizeof(Value) / sizeof(uint64_t);
+    static_assert(sizeof(Value) % sizeof(uint64_t) == 0, "Values are published as whole words");
+
+    void RefreshLoop();
+    void Publish(const std::vector<Value>& values);
+
+    KPMClient& m_kpm;
+    std::function<void()> m_listener;
+    std::thread m_thread;
+    std::atomic<bool> m_running{false};
+    std::atomic<int> m_rateHz{10};
+    std::atomic<int64_t> m_roundNs{0};
+
+    std::mutex m_mutex; // Guards the requested rows
+    std::condition_variable m_rowsChanged;
+    std::vector<std::pair<ADDRESS, int>> m_rows;
+    bool m_rowsDirty = false;
+
+    // Seqlock: odd while the worker writes
+    std::atomic<uint32_t> m_seq{0};
+    std::atomic<uint32_t> m_count{0};
+    std::atomic<uint64_t> m_words[MAX_ROWS * WORDS];
+};
+
+// Reads the chunks of a list of maps ahead of the scan loop: reader threads fill a ring of
+// 'depth' buffers while the caller compares the chunk before. Chunks come out in address
+// order whatever order the readers finish in. depth <= 1 reads on the caller's thread.
+class ChunkReader {
+public:
+    struct Chunk {
+        const MemoryMap* map;
+        ADDRESS addr;
+        size_t size;      // Requested
+        size_t bytesRead; // What read_raw returned
+        const uint8_t* data;
+    };
+
+    ChunkReader(KPMClient& kpm, ScanArena& arena, const std::vector<MemoryMap>& maps, size_t chunkSize, size_t depth, size_t readers);
+    ~ChunkReader(); // Stops the readers; a scan may leave early
+
+    // Next chunk, or null after the last. The previous chunk's buffer is reused from here on.
+    const Chunk* Next();
+    PipelineStats Stats();
+
+private:
+    void ReaderLoop();
+    size_t Released() const { return m_nextConsume ? m_nextConsume - 1 : 0; } // The last chunk returned is in use
+
+    KPMClient& m_kpm;
+    std::vector<Chunk> m_chunks;
+    std::vector<ScanArena::Array<uint8_t>> m_buffers; // Chunk i goes to buffer i % depth
+    std::vector<size_t> m_slotChunk;             // Chunk each buffer holds, SIZE_MAX while empty
+    size_t m_depth;
+    size_t m_nextRead = 0;    // Next chunk a reader claims
+    size_t m_nextConsume = 0; // Next chunk Next() returns; the ones before it are released
+    bool m_stop = false;
+    std::mutex m_mutex;
+    std::condition_variable m_slotFree;
+    std::condition_variable m_chunkReady;
+    std::vector<std::thread> m_readers;
+    PipelineStats m_stats;
+};
+
+// Chunk sizes picked by measurement instead of fixed: the user-side read chunk
+// (READ_CHUNK_SIZE) and the cap of the driver's search slice. AutotuneChunks picks a starting
+// size per lane; after that every scan updates the lane's throughput estimate for the size it
+// used, and every PROBE_EVERY scans one runs at a neighbouring size to see if that is faster.
+struct ChunkTuner {
+    static const size_t MIN_SIZE = 16 * 1024;
+    static const int SIZES = 7;       // MIN_SIZE << 0 .. 6, 16 KB to 1 MB
+    static const int PROBE_EVERY = 8;
+    static const uint64_t MIN_SAMPLE_BYTES = 8 * 1024 * 1024; // Smaller scans are too noisy to count
+
+    struct Lane {
+        double mbps[SIZES] = {}; // Smoothed scan throughput per size, 0 = not measured
+        int home = 3;            // Size scans use (128 KB)
+        int probe = -1;          // Size the next scan tries instead, -1 = none
+        bool probeUp = true;     // Direction of the next probe
+        uint32_t scans = 0;
+    };
+    Lane read;
+    Lane slice;
+    std::string device; // Fingerprint the lanes were tuned on, the key of the cache file
+
+    static size_t SizeOf(int i) { return MIN_SIZE << i; }
+    static int IndexOf(size_t size); // -1 if not one of the sizes
+    static size_t Current(const Lane& lane) { return SizeOf(lane.probe >= 0 ? lane.probe : lane.home); }
+    // Folds one scan into the lane; true if its home size moved
+    static bool Observe(Lane& lane, size_t sizeUsed, uint64_t bytes, double ms, uint64_t chunks, uint64_t shortReads);
+};
+
+// Per-page hits of the last user-side scan, keyed by a hash of each page's contents. A rescan
+// with the same query takes the hits of pages whose hash is unchanged instead of comparing
+// them again. Hits depend only on page contents, so moved maps or a new target simply miss.
+struct PageHashCache {
+    struct Range {
+        std::vector<uint64_t> hashes;   // Per page, 0 = not cached (unread or partial page)
+        std::vector<uint32_t> hitStart; // Per page, plus an end entry, into 'hits'
+        std::vector<uint16_t> hits;     // Offsets within the page
+    };
+    // The query and chunking the hits belong to
+    int type = -1;
+    int op = -1;
+    uint64_t a = 0, b = 0;
+    size_t chunkSize = 0;
+    std::map<ADDRESS, Range> ranges; // By map start address
+
+    bool Matches(int type, int op, const ScanOperand& operand, size_t chunkSize) const;
+};
+
+// The tool's own data as the memory budget counts it, in bytes. Spilled rows are viewed from
+// files the kernel can drop and reread, so they do not count against the budget.
+struct MemoryUsage {
+    uint64_t results = 0;   // m_results
+    uint64_t history = 0;   // Undo snapshots and removal bitmaps
+    uint64_t savedSets = 0;
+    uint64_t pageCache = 0;
+    uint64_t scratch = 0;   // Scan arena, free blocks included
+    uint64_t scanning = 0;  // Rows the running scan has collected so far
+    uint64_t spilled = 0;   // Result rows viewed from spill and loaded files
+    uint64_t processRss = 0; // Whole process, for comparison
+    uint64_t budget = 0;
+    uint64_t Total() const { return results + history + savedSets + pageCache + scratch + scanning; }
+};
+
+// Progress of the running background job: written by the job thread, polled by the UI
+struct JobProgress {
+    std::atomic<uint64_t> bytesDone{0}; // Bytes scanned, or items processed for refine / write
+    std::atomic<uint64_t> bytesTotal{0};
+    std::atomic<uint64_t> hits{0};
+    std::atomic<bool> cancel{false};    // Checked by the scan loops between chunks
+};
+
+// What changed on a worker thread, for a listener that redraws only when something it shows did
+enum ToolEvent {
+    EVENT_JOB = 1 << 0,    // A job finished; PollJobs has callbacks to run
+    EVENT_WATCH = 1 << 1,  // A watched value changed
+    EVENT_VALUES = 1 << 2, // The value cache published different text
+};
+
+struct ScanJob {
+    int id = 0;
+    std::string label;
+    bool cancelled = false;
+    std::function<void()> work;                  // Runs on the job thread
+    std::function<void(const ScanJob&)> onDone;  // Runs on the thread calling PollJobs()
 };
 
 // Enums
@@ -45,6 +811,17 @@ enum DataType {
     TYPE_WORD,
     TYPE_BYTE,
     TYPE_QWORD,
+    TYPE_AUTO, // Scan / refine only: tries every type the value fits in one pass, rows keep type masks
+};
+
+// Refines against the values captured by the previous pass
+enum CompareMode {
+    COMPARE_CHANGED,
+    COMPARE_UNCHANGED,
+    COMPARE_INCREASED,
+    COMPARE_DECREASED,
+    COMPARE_INCREASED_BY,
+    COMPARE_DECREASED_BY,
 };
 
 enum Range {
@@ -80,34 +857,66 @@ public:
     KPMClient kpm;
     
     // Modern Storage
-    std::vector<MemoryResult> m_results;
+    ResultStore m_results; // Replaced wholesale by CommitResults, read under m_resultsMutex
+    std::mutex m_resultsMutex;
+    std::atomic<bool> m_captureValues{true}; // Keep each result's last-seen value for compare refines (+width bytes per result)
     std::vector<FreezeItem> m_freezeItems;
     
     std::string m_pkgName;
-    int m_searchRange = Range::ALL;
+    std::atomic<int> m_searchRange{Range::ALL};
     
     // Threading
     std::thread m_freezeThread;
-    bool m_isFreezing = false;
-    bool m_safeMode = false; // Toggle for slow scanning
-    int m_freezeDelay = 30000; // us
+    std::atomic<bool> m_isFreezing{false};
+    std::atomic<bool> m_safeMode{false}; // Toggle for slow scanning
+    int m_freezeDelay = 30000; // us, default period for items without their own
+    std::mutex m_freezeMutex; // Guards m_freezeItems and m_freezeStats
+    std::atomic<bool> m_freezeDirty{true}; // Item list or periods changed, scheduler must regroup
+    std::atomic<bool> m_freezeCompare{false}; // Read-compare-write: only rewrite values the target has changed
+    std::vector<FreezeStats> m_freezeStats;
+    std::thread m_watchThread;
+    std::atomic<bool> m_isWatching{false};
+    std::atomic<int> m_watchRateHz{100}; // Sample rounds per second
+    std::mutex m_watchMutex; // Guards m_watchItems and m_watchStats
+    std::atomic<bool> m_watchDirty{true}; // Item list changed, sampler must rebuild its reads
+    std::vector<std::shared_ptr<WatchItem>> m_watchItems;
+    WatchStats m_watchStats;
     
     // Optimization
-    size_t READ_CHUNK_SIZE = 128 * 1024; // 128KB default
+    size_t READ_CHUNK_SIZE = 128 * 1024; // Set by the chunk tuner before each scan
+    // Settings below are written by the overlay and read by jobs mid-scan, hence atomic
+    std::atomic<size_t> m_chunkOverride{0};  // Fixed READ_CHUNK_SIZE, 0 = tuned
+    std::atomic<size_t> m_sliceOverride{0};  // Fixed driver search slice cap, 0 = tuned
+    std::atomic<bool> m_adaptChunks{true};   // Let scan throughput move the tuned sizes
+    ChunkTuner m_tuner;                      // Job thread only, after attach
+    ScanStats m_lastScan;                    // Job thread only, filled in by the running scan
+    std::atomic<int> m_readAhead{4};         // User-side scans: chunks in flight (1 = read, compare, read, ...)
+    std::atomic<int> m_readerThreads{1};     // Threads filling them; more only helps backends whose reads run in parallel
+    std::atomic<bool> m_pageHashSkip{true};  // Reuse hits of unchanged pages on user-side rescans (8 bytes per page + 2 per hit)
+    PageHashCache m_pageCache;  // Job thread only
+    ScanArena m_arena;          // Scratch buffers of scans, kept between them
+    AccessTracer m_tracer;      // One watched address at a time
+    ValueCache m_valueCache{kpm}; // Values of the visible result rows
+    std::atomic<size_t> m_memoryBudget{(size_t)1024 << 20}; // Heap the tool's data may use before it spills, 0 = unlimited
+    std::string m_spillDir = "/data/local/tmp";
 
     MemoryTool() = default;
     ~MemoryTool();
 
     // Initialization
-    void initXMemoryTools(const char* pkgName, const char* mode);
+    // Stops every worker, attaches, then queues the chunk autotune as a job. On failure returns
+    // false with the reason in 'error'.
+    bool initXMemoryTools(const char* pkgName, const char* mode, char* error = nullptr, size_t errorSize = 0);
     int getPID(const char* pkgName);
 
     // Helpers
     void SetSearchRange(int range);
-    int GetResultCount() const { return (int)m_results.size(); }
-    const std::vector<MemoryResult>& GetResults() const { return m_results; }
-    void ClearResults() { m_results.clear(); }
-    void PrintResults();
+    int GetResultCount() const { return (int)m_resultCount; } // As of the last finished job
+    ScanStats GetLastScan(); // Copy of m_lastScan as of the last finished job
+    void GetTunedSizes(size_t& read, size_t& slice); // m_tuner's home sizes as of the last finished job, 0 before one
+    const ResultStore& GetResults() const { return m_results; }
+    void ClearResults();
+    void PrintResults(size_t first = 0, size_t count = 100);
     int SetTextColor(int color);
     
     // Core Search
@@ -119,18 +928,122 @@ public:
     void RangeMemorySearch(const char* from_value, const char* to_value, int type);
     void RangeMemoryOffset(const char* from_value, const char* to_value, long int offset, int type);
 
+    // Refine History: every refine is a level on top of the last scan
+    bool UndoResults();
+    bool RedoResults();
+    int GetHistoryPos();   // 0 = the scan itself
+    int GetHistoryDepth(); // Levels including the scan, redo levels too
+    void GetHistoryLabel(int level, char* out, size_t size); // "" when out of range
+
+    // Named Result Sets: saved copies of m_results that can be reloaded or combined with it.
+    // Intersection and difference are refines (undoable); union starts a new history.
+    void SaveResultSet(const char* name);
+    bool LoadResultSet(const char* name);
+    void DeleteResultSet(const char* name);
+    bool CombineResultSet(int op, const char* name);
+    void GetResultSets(std::vector<std::pair<std::string, size_t>>& out); // Name and row count, reusing out's storage
+
+    // Persistence (format in ResultFile.h). setName = nullptr means m_results. Loads return a
+    // FileLoadStatus; files from another process instance are refused unless 'force'.
+    bool SaveResultsFile(const char* path, const char* setName = nullptr);
+    int LoadResultsFile(const char* path, const char* setName = nullptr, bool force = false);
+    bool SaveFreezeFile(const char* path);
+    int LoadFreezeFile(const char* path, bool force = false);
+    TargetFingerprint GetTargetFingerprint();
+
+    // Chunk Autotuning: times the read chunk and search slice sizes against the live backend
+    // within about 'budgetMs', or takes them from the per-device cache file unless 'force'.
+    // Runs on attach; scans then keep nudging the sizes unless m_adaptChunks is off.
+    void AutotuneChunks(bool force = false, double budgetMs = 300);
+    std::string GetDeviceFingerprint();
+
+    // Memory Budget: after every job, caches are dropped and result stores spilled to files in
+    // m_spillDir until the tool's data fits m_memoryBudget again. Scans spill as they go.
+    void EnforceMemoryBudget();
+    MemoryUsage GetMemoryUsage(); // As of the last job, with the running scan's rows live
+
+    // Result View: m_results filtered and sorted without touching the rows themselves. Building one
+    // reads the current values in batched spans when the query needs them, and counts per row how
+    // often they changed between builds. The getters and ClearResultView want m_resultsMutex held,
+    // like GetResults.
+    void BuildResultView(const ViewQuery& query);
+    const ResultView* GetResultView() const; // Null when none or stale
+    uint32_t GetChangeCount(size_t row) const; // 0 before the first value read
+    void ClearResultView();
+
+    // Compare Refine: keeps results whose value changed as asked since the last scan / refine.
+    // 'by' is the amount for COMPARE_INCREASED_BY / COMPARE_DECREASED_BY.
+    void MemoryCompare(int mode, const char* by = nullptr);
+
+    // Streaming Search: hits go to 'sink' and m_results is left alone. Returns false if cancelled.
+    bool MemorySearch(const char* value, int type, ResultSink& sink);
+    bool RangeMemorySearch(const char* from_value, const char* to_value, int type, ResultSink& sink);
+
     // Direct Write
     int WriteAddress(ADDRESS addr, const char* value, int type);
 
+    // Type table and scan kernels (see ScanKernels.h); kernels are picked once per job
+    static const TypeInfo& GetTypeInfo(int type);
+    static ScanKernelFn GetKernel(int type, int op, size_t stride);
+    static CompareKernelFn GetCompareKernel(int type, int op);
+    static size_t EncodeValue(const char* value, int type, void* out); // Returns byte width, 0 on bad type
+    static int FormatValue(const void* bytes, int type, char* out, size_t outSize);
+    static double ValueAsDouble(const void* bytes, int type);
+    static ScanOperand MakeOperand(int op, int type, const char* a, const char* b);
+    static ScanOperand MakeDeltaOperand(int type, double delta);
+    // Operands of an AUTO scan, one per DataType; returns the mask of types 'value' fits
+    static uint8_t MakeAutoOperands(const char* value, ScanOperand (&operands)[TYPE_AUTO]);
+
     // Freeze
     void StartFreeze();
     void StopFreeze();
-    void AddFreezeItem(ADDRESS addr, const char* value, int type, long int offset = 0);
-    void AddFreezeItem_All(const char* value, int type, long int offset = 0);
-    void RemoveFreezeItem(ADDRESS addr);
+    void AddFreezeItem(ADDRESS addr, const char* value, int type, long int offset = 0, int periodUs = 0);
+    void AddFreezeItem_All(const char* value, int type, long int offset = 0, int periodUs = 0);
+    size_t RemoveFreezeItem(ADDRESS addr); // Returns the items left
+    void SetFreezeItemPeriod(ADDRESS addr, int periodUs);
     void ClearFreezeItems();
     void PrintFreezeItems();
-    void SetFreezeDelay(long int delay) { m_freezeDelay = delay; }
+    void SetFreezeDelay(long int delay) { m_freezeDelay = delay; m_freezeDirty = true; }
+    void GetFreezeStats(std::vector<FreezeStats>& out);
+
+    // Watch List: samples the listed addresses at up to MAX_WATCH_RATE rounds a second into
+    // per-item rings. A round reads each span of nearby items once, so its cost grows with the
+    // distinct pages watched rather than with the items.
+    static const int MAX_WATCH_RATE = 5000;
+    void StartWatch();
+    void StopWatch();
+    std::shared_ptr<WatchItem> AddWatchItem(ADDRESS addr, int type); // The existing item if already watched
+    void RemoveWatchItem(ADDRESS addr);
+    void ClearWatchItems();
+    void GetWatchItems(std::vector<std::shared_ptr<WatchItem>>& out);
+    void SetWatchRate(int hz);
+    WatchStats GetWatchStats();
+
+    // Access Trace: which instructions write (or touch) the value at addr, through a hardware
+    // watchpoint on every target thread. Results accumulate in m_tracer until the next trace.
+    bool TraceAccess(ADDRESS addr, int type, int kind = TRACE_WRITES);
+
+    // Background Jobs
+    // Scans, refines and bulk writes run one at a time on a job thread so the overlay keeps drawing.
+    // Results are swapped in when a job finishes; a cancelled job leaves the old results alone.
+    JobProgress m_progress;
+    int SubmitJob(const char* label, std::function<void()> work, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitSearch(const char* value, int type, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitRangeSearch(const char* from_value, const char* to_value, int type, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitSearchTo(const char* label, const char* value, int type, std::shared_ptr<ResultSink> sink, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitRefine(const char* value, long int offset, int type, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitCompare(int mode, const char* by, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitCombine(int op, const char* name, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitWrite(const char* value, long int offset, int type, std::function<void(const ScanJob&)> onDone = nullptr);
+    int SubmitResultView(const ViewQuery& query, std::function<void(const ScanJob&)> onDone = nullptr);
+    void CancelJobs();
+    bool IsBusy();
+    void GetRunningJobLabel(char* out, size_t size);
+    int PollJobs(); // Runs completion callbacks of finished jobs, call once per frame
+    void StopJobs();
+    // 'listener(event)' runs on the job, watch and value cache threads when what the overlay
+    // shows changed, so it can sleep in between. Must be cheap; set before any of them start.
+    void SetChangeListener(std::function<void(int)> listener);
 
     // Misc
     int killprocess(const char* pkgName);
@@ -139,15 +1052,78 @@ public:
 private:
     std::vector<MemoryMap> readmaps(int type);
     
-    // Generic Search Implementation (Template usually better but keeping structure similar for porting)
-    template <typename T>
-    void SearchValue(T value, const std::vector<MemoryMap>& maps, int type);
-    
-    template <typename T>
-    void SearchRange(T from_val, T to_val, const std::vector<MemoryMap>& maps, int type);
+    // Driver-side (or emulated) batch search for EQ / NE / RANGE / MASK
+    bool SearchQuery(const kpm_search_query& query, const std::vector<MemoryMap>& maps, int type, ResultSink& sink);
+    static kpm_search_query MakeQuery(int op, int type, const ScanOperand& operand);
+
+    // User-side scan: bulk reads compared by a specialized kernel, any operator
+    bool SearchUser(int op, const ScanOperand& operand, const std::vector<MemoryMap>& maps, int type, ResultSink& sink);
+    bool SearchAuto(const char* value, const std::vector<MemoryMap>& maps, ResultSink& sink);
+    void RefineAuto(const char* value);
+
+    // Chunk sizes for the next scan, from the overrides or the tuner; and feedback from one
+    void ApplyChunkSizes();
+
+    MemoryUsage MeasureMemory();
+    void PrepareStoreSink(StoreSink& sink); // Spill limit and usage counter for a scan into m_results
+    std::string NextSpillPath();
+    std::mutex m_memoryMutex;
+    MemoryUsage m_memoryUsage; // Guarded by m_memoryMutex
+    std::atomic<uint64_t> m_scanHeapBytes{0};
+    std::atomic<uint32_t> m_spillSeq{0};
+    void ObserveChunkScan(const char* name, ChunkTuner::Lane& lane, size_t override, size_t sizeUsed, uint64_t bytes,
+                          double ms, uint64_t chunks, uint64_t shortReads);
+    void SaveTuneCache();
+
+    // Filters m_results by the value at +offset, or by its change against the value column
+    void RefineResults(int op, const ScanOperand& operand, long int offset, int type);
+    void CompareResults(int op, const ScanOperand& operand);
+    template <typename Filter>
+    void RefineSpans(const char* label, long int offset, int type, Filter filter);
+    void CaptureValues(ResultStore& store);
     
     // Freeze Loop
     void FreezeThreadLoop();
+    void WatchThreadLoop();
+    void NotifyChange(int event) { if (m_changeListener) m_changeListener(event); }
+    std::function<void(int)> m_changeListener;
+
+    void BeginProgress(uint64_t total);
+    void CommitResults(ResultStore&& results); // New scan: starts a fresh history
+    void CommitRefine(ResultStore&& results, std::vector<uint64_t>&& removed, const char* label);
+
+    // Refine history, guarded by m_resultsMutex
+    uint64_t m_resultsGen = 0; // Bumped whenever m_results gets other rows
+    std::shared_ptr<const ResultView> m_resultView;
+    std::vector<uint32_t> m_changeCounts; // Per row of m_results generation m_changeGen
+    std::vector<uint64_t> m_lastValues;   // Row values at the last view build, as double bits
+    uint64_t m_changeGen = ~(uint64_t)0;
+    std::vector<HistoryLevel> m_history;
+    size_t m_historyPos = 0;
+    std::unique_ptr<ResultStore> RebuildLevel(size_t level);
+    bool MoveToLevel(size_t target);
+    void EvictSnapshots();
+
+    // Saved sets are immutable once stored, so a job can keep using one after it is deleted
+    std::map<std::string, std::shared_ptr<const ResultStore>> m_resultSets;
+    std::mutex m_resultSetsMutex;
+
+    // Job executor
+    std::thread m_jobThread;
+    std::mutex m_jobMutex;
+    std::condition_variable m_jobCv;
+    std::deque<ScanJob> m_jobQueue;
+    std::vector<ScanJob> m_jobsDone;
+    bool m_jobExit = false;
+    int m_nextJobId = 0;
+    int m_runningJobId = 0;
+    std::string m_runningJobLabel;
+    // Published by the job thread as each job finishes, so the overlay never reads a scan's
+    // working state
+    std::atomic<size_t> m_resultCount{0};
+    ScanStats m_publishedScan; // Guarded by m_jobMutex
+    size_t m_publishedRead = 0, m_publishedSlice = 0; // Tuned sizes, guarded by m_jobMutex
+    void JobThreadLoop();
 
 public:
     std::string GetAddressValue(ADDRESS addr, int type);
@@ -2,6 +2,7 @@
 // Created by 泓清 on 2022/8/26.
 //
 #include "Android_touch/touch.h"
+#include <poll.h>
 
 
 #define FROM_SCREEN 0x0
@@ -96,6 +97,12 @@ void SetInputGrab(bool enable) {
     g_wantGrabState = enable;
 }
 
+static void (*g_touchListener)(int type) = nullptr;
+
+void SetTouchListener(void (*listener)(int type)) {
+    g_touchListener = listener;
+}
+
 static bool touchFlag = false;
 
 void touch_config() {
@@ -118,6 +125,8 @@ void touch_config() {
     input_event event{};
     ImVec2 touch_screen_size = getTouchScreenDimension(touch_device_fd);
     
+    // Sleeps in poll until the device has events; the timeout bounds how late a grab change lands
+    struct pollfd pfd = {touch_device_fd, POLLIN, 0};
     while (touchFlag) {
         // Handle Grab State Change
         if (g_wantGrabState != g_currentGrabState) {
@@ -184,11 +193,13 @@ void touch_config() {
                     imGuInputEvent.type = IM_UP;
                 }
                 ImGui_ImplLinux_HandleInputEvent(imGuInputEvent);
+                if (g_touchListener) g_touchListener(imGuInputEvent.type);
             } else {
                 events.push_back(event);
             }
+        } else {
+            poll(&pfd, 1, 50);
         }
-        std::this_thread::sleep_for(0.0001s);
     }
     
     // Ensure ungrab on exit
@@ -59,4 +59,6 @@ void touch_config();
 void Init_touch_config();
 void touchEnd();
 void SetInputGrab(bool enable);
+// Called on the touch thread after each event is handed to ImGui, with its IM_DOWN / IM_MOVE / IM_UP type
+void SetTouchListener(void (*listener)(int type));
 #endif
\ No newline at end of file
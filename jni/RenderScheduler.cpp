@@ -0,0 +1,68 @@
+#include "RenderScheduler.h"
+#include <thread>
+
+// ==============================================================================================
+// Render Scheduler
+// ==============================================================================================
+
+// Only the first post of an event since the last frame notifies, so a sampler posting at
+// kilohertz rates costs one wakeup per frame at most
+void RenderScheduler::Post(int events) {
+    int fresh = events & ~m_pending.fetch_or(events);
+    if (fresh & (m_interest | RENDER_INPUT)) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_wake.notify_one();
+    }
+}
+
+void RenderScheduler::SetInterest(int events, int timeoutMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_interest = events | RENDER_INPUT;
+    m_timeoutMs = timeoutMs;
+}
+
+void RenderScheduler::KeepHot() {
+    m_hotUntil = Clock::now() + std::chrono::milliseconds(HOT_MS);
+}
+
+int RenderScheduler::WaitForFrame() {
+    Clock::time_point start = Clock::now();
+    Clock::time_point earliest = m_lastFrame + std::chrono::milliseconds(FRAME_MS);
+
+    if (start < m_hotUntil) {
+        std::this_thread::sleep_until(earliest);
+    } else {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto due = [this]() { return (m_pending & m_interest) != 0; };
+        if (m_timeoutMs > 0) {
+            m_wake.wait_until(lock, m_lastFrame + std::chrono::milliseconds(m_timeoutMs), due);
+        } else {
+            m_wake.wait(lock, due);
+        }
+        lock.unlock();
+        // Events arriving faster than the full rate are merged into the next frame
+        std::this_thread::sleep_until(earliest);
+    }
+    int events = m_pending.exchange(0);
+
+    Clock::time_point now = Clock::now();
+    m_lastFrame = now;
+    m_windowIdle += now - start;
+    m_windowFrames++;
+    if (now - m_windowStart >= std::chrono::seconds(1)) {
+        double seconds = std::chrono::duration<double>(now - m_windowStart).count();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.fps = m_windowFrames / seconds;
+        m_stats.idlePct = 100.0 * std::chrono::duration<double>(m_windowIdle).count() / seconds;
+        m_stats.frames += m_windowFrames;
+        m_windowStart = now;
+        m_windowIdle = Clock::duration(0);
+        m_windowFrames = 0;
+    }
+    return events;
+}
+
+RenderStats RenderScheduler::Stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
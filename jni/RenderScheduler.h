@@ -0,0 +1,58 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+
+// Why the overlay should draw another frame. Posted from any thread.
+enum RenderEvent {
+    RENDER_INPUT = 1 << 0,  // Touch down or up
+    RENDER_DRAG = 1 << 1,   // Touch moved; only wakes while a touch is held on the overlay
+    RENDER_JOB = 1 << 2,    // A background job finished
+    RENDER_WATCH = 1 << 3,  // A watched value changed
+    RENDER_VALUES = 1 << 4, // The visible result rows have new values
+};
+
+struct RenderStats {
+    double fps = 0;     // Frames drawn per second over the last window
+    double idlePct = 0; // Share of the window spent waiting for a reason to draw
+    uint64_t frames = 0;
+};
+
+// Event-driven frame pacing for the overlay. The UI thread blocks in WaitForFrame until input
+// arrives, a worker posts an event the current screen shows, or the UI's own timeout runs out;
+// frames are never closer than FRAME_MS. After the UI reports an interaction, frames run at the
+// full rate for HOT_MS so ImGui can play out presses, releases and scrolling.
+class RenderScheduler {
+public:
+    static const int FRAME_MS = 16;
+    static const int HOT_MS = 500;
+
+    void Post(int events);
+    // UI thread, after each frame: the events the next frame waits for (RENDER_INPUT always
+    // counts), and the longest it sleeps without one, 0 = no limit
+    void SetInterest(int events, int timeoutMs);
+    void KeepHot(); // Draw at the full rate for another HOT_MS
+    // UI thread: blocks until the next frame is due. Returns the events posted since the last
+    // frame, 0 when the timeout or the hot period called it.
+    int WaitForFrame();
+    RenderStats Stats();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::atomic<int> m_pending{RENDER_INPUT}; // The first frame is drawn straight away
+    std::atomic<int> m_interest{RENDER_INPUT};
+    int m_timeoutMs = 0;
+    Clock::time_point m_lastFrame;
+    Clock::time_point m_hotUntil;
+
+    // Stats window, UI thread only apart from the published copy
+    Clock::time_point m_windowStart = Clock::now();
+    Clock::duration m_windowIdle{0};
+    uint64_t m_windowFrames = 0;
+    RenderStats m_stats; // Guarded by m_mutex
+};
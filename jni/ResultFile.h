@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// On-disk format for result sets and freeze lists.
+//
+// A file is a fixed header followed by sections at 8-byte aligned offsets. Every integer is
+// little-endian, and columns are plain fixed-width arrays, so a loader can mmap the file and
+// point at the address / value columns without parsing them. Only the small region table is
+// copied out.
+//
+//   ResultFileHeader
+//   regions:  regionCount x FileRegion, then the name bytes they point into
+//   runs:     runCount x FileRun (rows [firstRow, next.firstRow) belong to one region)
+//   addrs:    rowCount x uint64_t, ascending
+//   values:   rowCount x valueWidth bytes, if valueWidth != 0
+//   masks:    rowCount x uint8_t DataType bits, for AUTO scans (typeMasksOffset != 0)
+//
+// Freeze lists use the same header with FREEZE_FILE_MAGIC and rowCount x FileFreezeItem at
+// addrsOffset; they have no regions, runs or value column.
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+#error "Result files are read in place and assume a little-endian host"
+#endif
+
+static const char RESULT_FILE_MAGIC[8] = { 'M', 'T', 'R', 'E', 'S', 'U', 'L', 'T' };
+static const char FREEZE_FILE_MAGIC[8] = { 'M', 'T', 'F', 'R', 'E', 'E', 'Z', 'E' };
+static const uint32_t RESULT_FILE_VERSION = 2;
+
+// Identifies the target process a file was written against. Addresses only mean something in
+// the same process instance: a pid can be recycled, so the process start time is kept as well.
+struct TargetFingerprint {
+    int32_t pid = 0;
+    uint32_t reserved = 0;
+    uint64_t startTime = 0; // /proc/<pid>/stat field 22, in clock ticks since boot
+    uint64_t mapsHash = 0;  // FNV-1a over the writable maps (range and name)
+};
+
+struct ResultFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t fileSize;
+    uint64_t rowCount;
+    uint32_t type;
+    uint32_t valueWidth;
+    uint32_t regionCount;
+    uint32_t runCount;
+    uint64_t regionsOffset;
+    uint64_t runsOffset;
+    uint64_t addrsOffset;
+    uint64_t valuesOffset;
+    uint64_t typeMasksOffset; // 0 when the rows carry no type masks
+    TargetFingerprint target;
+};
+
+struct FileRegion {
+    uint32_t nameOffset; // From regionsOffset
+    uint32_t nameLength;
+};
+
+struct FileRun {
+    uint64_t firstRow;
+    uint32_t region;
+    uint32_t reserved;
+};
+
+struct FileFreezeItem {
+    uint64_t addr;
+    uint8_t bytes[8];
+    uint32_t type;
+    int32_t periodUs;
+};
+
+// How a loaded file relates to the current target
+enum FileLoadStatus {
+    FILE_LOAD_OK,           // Same process, same maps
+    FILE_LOAD_MAPS_CHANGED, // Same process, but its maps changed since the save: loaded, check before writing
+    FILE_LOAD_STALE,        // Another process instance: addresses are meaningless, not loaded unless forced
+    FILE_LOAD_BAD_FILE,     // Missing, truncated, or not a file of this kind / version
+};
+
+// A read-only mapping, unmapped when the last store viewing it goes away
+struct MappedFile {
+    void* base = nullptr;
+    size_t length = 0;
+    ~MappedFile();
+};
@@ -0,0 +1,619 @@
+#include "MemoryTool.h"
+#include <algorithm>
+#include <cstring>
+#include <thread>
+#include <cstdio>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+// ==============================================================================================
+// Result Store
+// ==============================================================================================
+
+void ResultStore::Clear() {
+    m_view.reset();
+    m_viewAddrs = nullptr;
+    m_viewValues = nullptr;
+    m_viewTypeMasks = nullptr;
+    m_viewRows = 0;
+    m_addrs.clear();
+    DropValues();
+    std::vector<uint8_t>().swap(m_typeMasks);
+    m_hasTypeMasks = false;
+    m_runs.clear();
+    m_regions.clear();
+    m_regionIndex.clear();
+}
+
+void ResultStore::Swap(ResultStore& other) {
+    std::swap(type, other.type);
+    m_addrs.swap(other.m_addrs);
+    m_values.swap(other.m_values);
+    std::swap(m_valueWidth, other.m_valueWidth);
+    m_typeMasks.swap(other.m_typeMasks);
+    std::swap(m_hasTypeMasks, other.m_hasTypeMasks);
+    m_runs.swap(other.m_runs);
+    m_regions.swap(other.m_regions);
+    m_regionIndex.swap(other.m_regionIndex);
+    m_view.swap(other.m_view);
+    std::swap(m_viewAddrs, other.m_viewAddrs);
+    std::swap(m_viewValues, other.m_viewValues);
+    std::swap(m_viewTypeMasks, other.m_viewTypeMasks);
+    std::swap(m_viewRows, other.m_viewRows);
+}
+
+void ResultStore::Materialize() {
+    if (!m_view) return;
+    m_addrs.assign(m_viewAddrs, m_viewAddrs + m_viewRows);
+    if (m_valueWidth) m_values.assign(m_viewValues, m_viewValues + m_viewRows * m_valueWidth);
+    if (m_hasTypeMasks) m_typeMasks.assign(m_viewTypeMasks, m_viewTypeMasks + m_viewRows);
+    m_view.reset();
+    m_viewAddrs = nullptr;
+    m_viewValues = nullptr;
+    m_viewTypeMasks = nullptr;
+    m_viewRows = 0;
+}
+
+size_t ResultStore::RunOf(size_t row) const {
+    auto it = std::upper_bound(m_runs.begin(), m_runs.end(), row,
+        [](size_t r, const RegionRun& run) { return r < run.firstRow; });
+    return (size_t)(it - m_runs.begin()) - 1;
+}
+
+const std::string& ResultStore::RegionName(size_t i) const {
+    return m_regions[m_runs[RunOf(i)].region];
+}
+
+size_t ResultStore::LowerBound(ADDRESS addr) const {
+    return (size_t)(std::lower_bound(Addrs(), Addrs() + Size(), addr) - Addrs());
+}
+
+void ResultStore::EnableValues(uint32_t width) {
+    Materialize();
+    m_values.clear();
+    m_valueWidth = width;
+}
+
+void ResultStore::DropValues() {
+    Materialize();
+    std::vector<uint8_t>().swap(m_values);
+    m_valueWidth = 0;
+}
+
+void ResultStore::AppendValues(const uint8_t* packed, size_t count) {
+    Materialize();
+    m_values.insert(m_values.end(), packed, packed + count * m_valueWidth);
+}
+
+void ResultStore::SetValues(std::vector<uint8_t>&& packed, uint32_t width) {
+    Materialize();
+    m_values.swap(packed);
+    m_valueWidth = width;
+}
+
+void ResultStore::EnableTypeMasks() {
+    Materialize();
+    m_typeMasks.clear();
+    m_hasTypeMasks = true;
+}
+
+void ResultStore::AppendTypeMasks(const uint8_t* masks, size_t count) {
+    Materialize();
+    m_typeMasks.insert(m_typeMasks.end(), masks, masks + count);
+}
+
+uint8_t ResultStore::MaskOf(size_t row) const {
+    return m_hasTypeMasks ? TypeMask(row) : (uint8_t)(1u << type);
+}
+
+uint32_t ResultStore::InternRegion(const std::string& name) {
+    auto it = m_regionIndex.find(name);
+    if (it != m_regionIndex.end()) return it->second;
+    uint32_t idx = (uint32_t)m_regions.size();
+    m_regions.push_back(name);
+    m_regionIndex.emplace(name, idx);
+    return idx;
+}
+
+void ResultStore::Append(const ADDRESS* addrs, size_t count, const std::string& region) {
+    if (count == 0) return;
+    Materialize();
+    uint32_t r = InternRegion(region);
+    if (m_runs.empty() || m_runs.back().region != r) m_runs.push_back({m_addrs.size(), r});
+    m_addrs.insert(m_addrs.end(), addrs, addrs + count);
+}
+
+void ResultStore::AppendRows(const ResultStore& src, const uint32_t* rows, size_t count, const uint8_t* masks) {
+    if (count == 0) return;
+    Materialize();
+    const ADDRESS* srcAddrs = src.Addrs();
+    size_t run = src.RunOf(rows[0]);
+    uint32_t srcRegion = UINT32_MAX;
+    uint32_t region = 0;
+    for (size_t i = 0; i < count; i++) {
+        size_t row = rows[i];
+        while (run + 1 < src.m_runs.size() && src.m_runs[run + 1].firstRow <= row) run++;
+        // Rows of a refine mostly share their source run, so interning happens once per run
+        if (src.m_runs[run].region != srcRegion) {
+            srcRegion = src.m_runs[run].region;
+            region = InternRegion(src.m_regions[srcRegion]);
+        }
+        if (m_runs.empty() || m_runs.back().region != region) m_runs.push_back({m_addrs.size(), region});
+        m_addrs.push_back(srcAddrs[row]);
+        if (m_hasTypeMasks) m_typeMasks.push_back(masks ? masks[i] : src.MaskOf(row));
+    }
+}
+
+void ResultStore::AppendKept(const ResultStore& src, const uint64_t* removed) {
+    const size_t rows = src.Size();
+    uint32_t kept[64];
+    for (size_t w = 0; w * 64 < rows; w++) {
+        uint64_t mask = ~removed[w];
+        if (rows - w * 64 < 64) mask &= (1ULL << (rows - w * 64)) - 1;
+        size_t n = 0;
+        while (mask) {
+            kept[n++] = (uint32_t)(w * 64 + (size_t)__builtin_ctzll(mask));
+            mask &= mask - 1;
+        }
+        AppendRows(src, kept, n);
+        if (m_valueWidth && src.m_valueWidth == m_valueWidth) {
+            for (size_t i = 0; i < n; i++) AppendValues(src.Value(kept[i]), 1);
+        }
+    }
+}
+
+bool ResultStore::IsSorted() const {
+    return std::is_sorted(Addrs(), Addrs() + Size());
+}
+
+void ResultStore::Sort() {
+    if (IsSorted()) return;
+    Materialize();
+    struct Row {
+        ADDRESS addr;
+        uint32_t region;
+        uint32_t index; // Old position, to carry the value column along
+    };
+    std::vector<Row> rows(m_addrs.size());
+    for (size_t run = 0; run < m_runs.size(); run++) {
+        size_t end = run + 1 < m_runs.size() ? m_runs[run + 1].firstRow : m_addrs.size();
+        for (size_t i = m_runs[run].firstRow; i < end; i++) rows[i] = {m_addrs[i], m_runs[run].region, (uint32_t)i};
+    }
+    std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) { return a.addr < b.addr; });
+
+    std::vector<uint8_t> values(m_values.size());
+    std::vector<uint8_t> masks(m_typeMasks.size());
+    m_runs.clear();
+    for (size_t i = 0; i < rows.size(); i++) {
+        m_addrs[i] = rows[i].addr;
+        if (m_valueWidth) memcpy(&values[i * m_valueWidth], &m_values[(size_t)rows[i].index * m_valueWidth], m_valueWidth);
+        if (m_hasTypeMasks) masks[i] = m_typeMasks[rows[i].index];
+        if (m_runs.empty() || m_runs.back().region != rows[i].region) m_runs.push_back({i, rows[i].region});
+    }
+    m_values.swap(values);
+    m_typeMasks.swap(masks);
+}
+
+// ==============================================================================================
+// Result Sinks
+// ==============================================================================================
+
+void StoreSink::Begin(int type) {
+    store.Clear();
+    store.type = type;
+    m_parts.clear();
+    m_spills = 0;
+}
+
+bool StoreSink::Consume(const ADDRESS* addrs, size_t n, const MemoryMap& map) {
+    store.Append(addrs, n, map.name);
+    Spill();
+    return true;
+}
+
+bool StoreSink::ConsumeTyped(const ADDRESS* addrs, const uint8_t* typeMasks, size_t n, const MemoryMap& map) {
+    if (!store.HasTypeMasks()) store.EnableTypeMasks();
+    store.Append(addrs, n, map.name);
+    store.AppendTypeMasks(typeMasks, n);
+    Spill();
+    return true;
+}
+
+// Moves the store to a part file once it is over the limit
+void StoreSink::Spill() {
+    size_t bytes = store.HeapBytes();
+    if (spillBytes && bytes > spillBytes) {
+        ResultStore part;
+        part.Swap(store);
+        std::string path = spillPath + "." + std::to_string(m_spills);
+        if (part.Spill(path.c_str())) {
+            store.type = part.type;
+            if (part.HasTypeMasks()) store.EnableTypeMasks();
+            m_parts.push_back(std::move(part));
+            m_spills++;
+            bytes = 0;
+        } else {
+            // Disk full or not writable: keep going on the heap
+            printf("[Warn] Cannot spill scan results to %s, keeping them in memory\n", path.c_str());
+            store.Swap(part);
+            spillBytes = 0;
+        }
+    }
+    if (heapBytes) *heapBytes = bytes;
+}
+
+void StoreSink::End(bool cancelled) {
+    if (heapBytes) *heapBytes = 0; // The rows are the caller's now, counted wherever they go
+    if (cancelled || m_parts.empty()) {
+        m_parts.clear();
+        return;
+    }
+    std::vector<const ResultStore*> parts;
+    for (const auto& part : m_parts) parts.push_back(&part);
+    parts.push_back(&store);
+
+    ResultStore joined;
+    std::string path = spillPath + ".all";
+    if (ResultStore::WriteFile(path.c_str(), parts.data(), parts.size(), TargetFingerprint()) && joined.MapFile(path.c_str(), nullptr)) {
+        unlink(path.c_str());
+    } else {
+        unlink(path.c_str());
+        printf("[Warn] Cannot join spilled scan results in %s, reading them back into memory\n", path.c_str());
+        joined.Clear();
+        joined.type = store.type;
+        if (store.HasTypeMasks()) joined.EnableTypeMasks();
+        for (const ResultStore* part : parts) {
+            std::vector<uint64_t> none((part->Size() + 63) / 64, 0);
+            joined.AppendKept(*part, none.data());
+        }
+    }
+    store.Swap(joined);
+    m_parts.clear();
+}
+
+WriteSink::WriteSink(KPMClient& kpm, const char* value, int type, long int offset)
+    : m_kpm(kpm), m_offset(offset) {
+    m_size = MemoryTool::EncodeValue(value, type, m_bytes);
+}
+
+bool WriteSink::Consume(const ADDRESS* addrs, size_t n, const MemoryMap& /*map*/) {
+    if (m_size == 0) return false;
+    for (size_t i = 0; i < n; i++) {
+        if (m_kpm.write_raw(addrs[i] + m_offset, m_bytes, m_size) == m_size) written++;
+    }
+    return true;
+}
+
+FreezeSink::FreezeSink(MemoryTool& tool, const char* value, int type, long int offset, int periodUs)
+    : m_tool(tool), m_value(value), m_type(type), m_offset(offset), m_periodUs(periodUs) {}
+
+bool FreezeSink::Consume(const ADDRESS* addrs, size_t n, const MemoryMap& /*map*/) {
+    for (size_t i = 0; i < n; i++) {
+        m_tool.AddFreezeItem(addrs[i], m_value.c_str(), m_type, m_offset, m_periodUs);
+    }
+    added += n;
+    return true;
+}
+
+// ==============================================================================================
+// Set Algebra
+// ==============================================================================================
+
+// Below this many rows a single merge is faster than starting threads
+static const size_t SET_PARALLEL_MIN_ROWS = 1 << 20;
+
+// Row references of a union: bit 31 tells which input the row comes from
+static const uint32_t SET_ROW_FROM_B = 0x80000000u;
+
+// Linear merge of a[aBegin, aEnd) with b[bBegin, bEnd). Intersection and difference emit rows
+// of 'a'; union emits tagged references into either input.
+static void MergeRange(const ADDRESS* a, size_t aBegin, size_t aEnd, const ADDRESS* b, size_t bBegin, size_t bEnd,
+                       int op, std::vector<uint32_t>& out) {
+    size_t i = aBegin, j = bBegin;
+    while (i < aEnd && j < bEnd) {
+        if (a[i] < b[j]) {
+            if (op != SET_INTERSECT) out.push_back((uint32_t)i);
+            i++;
+        } else if (b[j] < a[i]) {
+            if (op == SET_UNION) out.push_back((uint32_t)j | SET_ROW_FROM_B);
+            j++;
+        } else {
+            if (op != SET_DIFFERENCE) out.push_back((uint32_t)i);
+            i++;
+            j++;
+        }
+    }
+    if (op != SET_INTERSECT) for (; i < aEnd; i++) out.push_back((uint32_t)i);
+    if (op == SET_UNION) for (; j < bEnd; j++) out.push_back((uint32_t)j | SET_ROW_FROM_B);
+}
+
+// Runs fn(part) for every part, the last one on the calling thread
+template <typename Fn>
+static void RunParts(size_t parts, Fn fn) {
+    std::vector<std::thread> workers;
+    for (size_t p = 0; p + 1 < parts; p++) workers.emplace_back(fn, p);
+    fn(parts - 1);
+    for (auto& w : workers) w.join();
+}
+
+void ResultStore::Combine(const ResultStore& a, const ResultStore& b, int op, ResultStore& out, std::vector<uint64_t>* removed) {
+    // Both inputs are address-sorted, so splitting 'a' into equal row ranges and finding the
+    // matching ranges of 'b' by binary search gives independent merges. Cuts fall on multiples
+    // of 64 rows so no two parts share a word of the removal bitmap.
+    size_t parts = 1;
+    if (a.Size() + b.Size() >= SET_PARALLEL_MIN_ROWS) {
+        parts = std::max(1u, std::thread::hardware_concurrency());
+        parts = std::min<size_t>(parts, 16);
+    }
+    if (a.Size() < parts * 64) parts = 1;
+    std::vector<size_t> aCut(parts + 1), bCut(parts + 1);
+    for (size_t p = 0; p <= parts; p++) {
+        aCut[p] = p == parts ? a.Size() : (a.Size() * p / parts) & ~(size_t)63;
+        if (p == 0) bCut[p] = 0;
+        else if (p == parts) bCut[p] = b.Size();
+        else bCut[p] = std::lower_bound(b.Addrs(), b.Addrs() + b.Size(), a.Addr(aCut[p])) - b.Addrs();
+    }
+
+    std::vector<std::vector<uint32_t>> rows(parts);
+    RunParts(parts, [&](size_t p) {
+        MergeRange(a.Addrs(), aCut[p], aCut[p + 1], b.Addrs(), bCut[p], bCut[p + 1], op, rows[p]);
+    });
+
+    // Values survive when both inputs carry them at the same width. Rows carry type masks when
+    // 'a' does, or when a union mixes in rows of other types.
+    out.Clear();
+    out.type = a.type;
+    bool values = a.HasValues() && (op != SET_UNION || b.ValueWidth() == a.ValueWidth());
+    if (values) out.EnableValues(a.ValueWidth());
+    bool masks = a.HasTypeMasks() || (op == SET_UNION && (b.HasTypeMasks() || b.type != a.type));
+    if (masks) {
+        out.type = TYPE_AUTO;
+        out.EnableTypeMasks();
+    }
+    if (removed && op != SET_UNION) removed->assign((a.Size() + 63) / 64, ~0ULL);
+    else removed = nullptr;
+
+    // Region names are interned up front so the parts can map regions without touching 'out'
+    std::vector<uint32_t> regionMap[2];
+    regionMap[0].resize(a.m_regions.size());
+    for (size_t r = 0; r < a.m_regions.size(); r++) regionMap[0][r] = out.InternRegion(a.m_regions[r]);
+    if (op == SET_UNION) {
+        regionMap[1].resize(b.m_regions.size());
+        for (size_t r = 0; r < b.m_regions.size(); r++) regionMap[1][r] = out.InternRegion(b.m_regions[r]);
+    }
+
+    std::vector<size_t> first(parts + 1, 0);
+    for (size_t p = 0; p < parts; p++) first[p + 1] = first[p] + rows[p].size();
+    out.m_addrs.resize(first[parts]);
+    if (values) out.m_values.resize(first[parts] * out.m_valueWidth);
+    if (masks) out.m_typeMasks.resize(first[parts]);
+
+    // Each part writes its slice of the output. Rows of each input arrive ascending, so one
+    // run cursor per input replaces a lookup per row.
+    std::vector<std::vector<RegionRun>> runs(parts);
+    RunParts(parts, [&](size_t p) {
+        const ResultStore* srcs[2] = { &a, &b };
+        size_t run[2] = { 0, 0 };
+        if (!rows[p].empty()) {
+            run[0] = a.m_runs.empty() ? 0 : a.RunOf(aCut[p] < a.Size() ? aCut[p] : a.Size() - 1);
+            run[1] = b.m_runs.empty() ? 0 : b.RunOf(bCut[p] < b.Size() ? bCut[p] : b.Size() - 1);
+        }
+        size_t w = first[p];
+        for (uint32_t ref : rows[p]) {
+            int from = (ref & SET_ROW_FROM_B) ? 1 : 0;
+            size_t row = ref & ~SET_ROW_FROM_B;
+            const ResultStore& src = *srcs[from];
+            while (run[from] + 1 < src.m_runs.size() && src.m_runs[run[from] + 1].firstRow <= row) run[from]++;
+            uint32_t region = regionMap[from][src.m_runs[run[from]].region];
+            if (runs[p].empty() || runs[p].back().region != region) runs[p].push_back({w, region});
+            out.m_addrs[w] = src.Addr(row);
+            if (values) memcpy(&out.m_values[w * out.m_valueWidth], src.Value(row), out.m_valueWidth);
+            if (masks) out.m_typeMasks[w] = src.MaskOf(row);
+            if (removed && !from) (*removed)[row / 64] &= ~(1ULL << (row % 64));
+            w++;
+        }
+    });
+
+    for (const auto& part : runs) {
+        for (const auto& r : part) {
+            if (out.m_runs.empty() || out.m_runs.back().region != r.region) out.m_runs.push_back(r);
+        }
+    }
+}
+
+// ==============================================================================================
+// File Format
+// ==============================================================================================
+
+MappedFile::~MappedFile() {
+    if (base) munmap(base, length);
+}
+
+static uint64_t AlignFile(uint64_t offset) {
+    return (offset + 7) & ~7ULL;
+}
+
+// Writes 'len' bytes at 'offset', zero-padding from the current position
+static bool WriteSection(FILE* fp, uint64_t& pos, uint64_t offset, const void* data, size_t len) {
+    static const uint8_t zeros[8] = {};
+    if (offset < pos || offset - pos > sizeof(zeros)) return false;
+    if (offset > pos && fwrite(zeros, 1, offset - pos, fp) != offset - pos) return false;
+    if (len && fwrite(data, 1, len, fp) != len) return false;
+    pos = offset + len;
+    return true;
+}
+
+bool ResultStore::WriteFile(const char* path, const TargetFingerprint& target) const {
+    const ResultStore* self = this;
+    return WriteFile(path, &self, 1, target);
+}
+
+bool ResultStore::WriteFile(const char* path, const ResultStore* const* parts, size_t count, const TargetFingerprint& target) {
+    // Regions are merged by name; a run that continues the previous part's last region joins it
+    std::vector<std::string> names;
+    std::unordered_map<std::string, uint32_t> nameIndex;
+    std::vector<FileRun> runs;
+    uint64_t rows = 0;
+    for (size_t p = 0; p < count; p++) {
+        const ResultStore& part = *parts[p];
+        for (const RegionRun& run : part.m_runs) {
+            const std::string& name = part.m_regions[run.region];
+            auto it = nameIndex.emplace(name, (uint32_t)names.size());
+            if (it.second) names.push_back(name);
+            if (runs.empty() || runs.back().region != it.first->second) runs.push_back({ rows + run.firstRow, it.first->second, 0 });
+        }
+        rows += part.Size();
+    }
+    std::vector<FileRegion> regions(names.size());
+    std::string nameBytes;
+    for (size_t r = 0; r < names.size(); r++) {
+        regions[r].nameOffset = (uint32_t)(regions.size() * sizeof(FileRegion) + nameBytes.size());
+        regions[r].nameLength = (uint32_t)names[r].size();
+        nameBytes += names[r];
+    }
+    const uint32_t valueWidth = count ? parts[0]->m_valueWidth : 0;
+    const bool hasTypeMasks = count && parts[0]->m_hasTypeMasks;
+    for (size_t p = 0; p < count; p++) {
+        if (parts[p]->m_valueWidth != valueWidth || parts[p]->m_hasTypeMasks != hasTypeMasks) return false;
+    }
+
+    ResultFileHeader h{};
+    memcpy(h.magic, RESULT_FILE_MAGIC, sizeof(h.magic));
+    h.version = RESULT_FILE_VERSION;
+    h.headerSize = sizeof(h);
+    h.rowCount = rows;
+    h.type = count ? (uint32_t)parts[0]->type : 0;
+    h.valueWidth = valueWidth;
+    h.regionCount = (uint32_t)regions.size();
+    h.runCount = (uint32_t)runs.size();
+    h.regionsOffset = AlignFile(sizeof(h));
+    h.runsOffset = AlignFile(h.regionsOffset + regions.size() * sizeof(FileRegion) + nameBytes.size());
+    h.addrsOffset = AlignFile(h.runsOffset + runs.size() * sizeof(FileRun));
+    h.valuesOffset = h.addrsOffset + h.rowCount * sizeof(ADDRESS);
+    h.fileSize = h.valuesOffset + h.rowCount * valueWidth;
+    if (hasTypeMasks) {
+        h.typeMasksOffset = h.fileSize;
+        h.fileSize += h.rowCount;
+    }
+    h.target = target;
+
+    std::string tmp = std::string(path) + ".tmp";
+    FILE* fp = fopen(tmp.c_str(), "wb");
+    if (!fp) {
+        printf("[Error] Cannot create %s: %s\n", tmp.c_str(), strerror(errno));
+        return false;
+    }
+    uint64_t pos = 0;
+    bool ok = WriteSection(fp, pos, 0, &h, sizeof(h)) &&
+              WriteSection(fp, pos, h.regionsOffset, regions.data(), regions.size() * sizeof(FileRegion)) &&
+              WriteSection(fp, pos, pos, nameBytes.data(), nameBytes.size()) &&
+              WriteSection(fp, pos, h.runsOffset, runs.data(), runs.size() * sizeof(FileRun));
+    // Each column is the parts' columns back to back
+    for (size_t p = 0; p < count && ok; p++) {
+        ok = WriteSection(fp, pos, p ? pos : h.addrsOffset, parts[p]->Addrs(), parts[p]->Size() * sizeof(ADDRESS));
+    }
+    for (size_t p = 0; p < count && ok; p++) {
+        ok = WriteSection(fp, pos, p ? pos : h.valuesOffset, parts[p]->Values(), parts[p]->Size() * valueWidth);
+    }
+    for (size_t p = 0; p < count && ok && hasTypeMasks; p++) {
+        ok = WriteSection(fp, pos, p ? pos : h.typeMasksOffset, parts[p]->TypeMasks(), parts[p]->Size());
+    }
+    ok = ok && fflush(fp) == 0 && fsync(fileno(fp)) == 0;
+    ok = (fclose(fp) == 0) && ok;
+    if (!ok || rename(tmp.c_str(), path) != 0) {
+        printf("[Error] Failed to write %s: %s\n", path, strerror(errno));
+        unlink(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool ResultStore::SpillTo(const char* path, ResultStore& out) const {
+    bool ok = WriteFile(path, TargetFingerprint()) && out.MapFile(path, nullptr);
+    unlink(path); // The mapping keeps the pages; the file goes away with the last view
+    return ok;
+}
+
+bool ResultStore::Spill(const char* path) {
+    ResultStore mapped;
+    if (!SpillTo(path, mapped)) return false;
+    Swap(mapped);
+    return true;
+}
+
+size_t ResultStore::HeapBytes() const {
+    size_t bytes = m_addrs.capacity() * sizeof(ADDRESS) + m_values.capacity() + m_typeMasks.capacity() +
+                   m_runs.capacity() * sizeof(RegionRun);
+    for (const auto& name : m_regions) bytes += sizeof(std::string) + name.capacity() * 2; // Plus the index's copy
+    return bytes;
+}
+
+bool ResultStore::MapFile(const char* path, TargetFingerprint* target) {
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(ResultFileHeader)) {
+        close(fd);
+        return false;
+    }
+    void* base = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) return false;
+    std::shared_ptr<MappedFile> file = std::make_shared<MappedFile>();
+    file->base = base;
+    file->length = (size_t)st.st_size;
+
+    // Everything below indexes into the mapping, so bounds are checked before any use
+    const uint8_t* bytes = (const uint8_t*)base;
+    ResultFileHeader h;
+    memcpy(&h, bytes, sizeof(h));
+    const uint64_t size = file->length;
+    bool ok = memcmp(h.magic, RESULT_FILE_MAGIC, sizeof(h.magic)) == 0 && h.version == RESULT_FILE_VERSION &&
+              h.headerSize == sizeof(h) && h.fileSize == size &&
+              (h.valueWidth == 0 || h.valueWidth == 1 || h.valueWidth == 2 || h.valueWidth == 4 || h.valueWidth == 8) &&
+              h.rowCount <= size / sizeof(ADDRESS) && h.addrsOffset % 8 == 0 &&
+              h.regionsOffset <= size && (uint64_t)h.regionCount * sizeof(FileRegion) <= size - h.regionsOffset &&
+              h.runsOffset <= size && (uint64_t)h.runCount * sizeof(FileRun) <= size - h.runsOffset &&
+              h.addrsOffset <= size && h.rowCount * sizeof(ADDRESS) <= size - h.addrsOffset &&
+              h.valuesOffset <= size && h.rowCount * h.valueWidth <= size - h.valuesOffset &&
+              (h.typeMasksOffset == 0 || (h.typeMasksOffset <= size && h.rowCount <= size - h.typeMasksOffset));
+    if (!ok) return false;
+
+    std::vector<std::string> regions(h.regionCount);
+    for (uint32_t r = 0; r < h.regionCount; r++) {
+        FileRegion fr;
+        memcpy(&fr, bytes + h.regionsOffset + r * sizeof(FileRegion), sizeof(fr));
+        if ((uint64_t)fr.nameOffset + fr.nameLength > size - h.regionsOffset) return false;
+        regions[r].assign((const char*)bytes + h.regionsOffset + fr.nameOffset, fr.nameLength);
+    }
+    std::vector<RegionRun> runs(h.runCount);
+    for (uint32_t r = 0; r < h.runCount; r++) {
+        FileRun run;
+        memcpy(&run, bytes + h.runsOffset + r * sizeof(FileRun), sizeof(run));
+        bool ascending = r == 0 ? run.firstRow == 0 : run.firstRow > runs[r - 1].firstRow;
+        if (!ascending || run.firstRow >= h.rowCount || run.region >= h.regionCount) return false;
+        runs[r] = { (size_t)run.firstRow, run.region };
+    }
+    if (h.rowCount && runs.empty()) return false;
+
+    Clear();
+    type = (int)h.type;
+    m_regions.swap(regions);
+    for (size_t r = 0; r < m_regions.size(); r++) m_regionIndex.emplace(m_regions[r], (uint32_t)r);
+    m_runs.swap(runs);
+    m_valueWidth = h.valueWidth;
+    m_viewRows = (size_t)h.rowCount;
+    m_viewAddrs = (const ADDRESS*)(bytes + h.addrsOffset);
+    m_viewValues = bytes + h.valuesOffset;
+    m_hasTypeMasks = h.typeMasksOffset != 0;
+    m_viewTypeMasks = m_hasTypeMasks ? bytes + h.typeMasksOffset : nullptr;
+    m_view = file;
+
+    // Columns fault in on first touch; start reading them ahead in the background
+    madvise(base, file->length, MADV_WILLNEED);
+    if (target) *target = h.target;
+    return true;
+}
@@ -0,0 +1,113 @@
+#include "MemoryTool.h"
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+// ==============================================================================================
+// Scan Arena
+// ==============================================================================================
+
+// Blocks are whole pages below HUGE_PAGE and whole huge pages from there on, so that
+// transparent huge pages can back all of them
+static size_t BlockSize(size_t bytes) {
+    static const size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    const size_t unit = bytes >= ScanArena::HUGE_PAGE ? ScanArena::HUGE_PAGE : page;
+    return (std::max<size_t>(bytes, 1) + unit - 1) / unit * unit;
+}
+
+ScanArena::~ScanArena() {
+    for (const auto& block : m_free) munmap(block.second, block.first);
+}
+
+void* ScanArena::Take(size_t bytes, size_t& block) {
+    const size_t want = BlockSize(bytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.acquires++;
+
+    // Best fit among the free blocks, but no more than twice the size asked for
+    auto it = m_free.lower_bound(want);
+    if (it != m_free.end() && it->first <= want * 2) {
+        block = it->first;
+        void* base = it->second;
+        m_free.erase(it);
+        m_stats.bytesFree -= block;
+        m_stats.reuses++;
+        return base;
+    }
+
+    // Huge blocks are mapped with a huge page of slack and trimmed to a huge page boundary
+    const size_t slack = want >= HUGE_PAGE ? HUGE_PAGE : 0;
+    void* raw = mmap(nullptr, want + slack, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) throw std::bad_alloc();
+    uint8_t* base = (uint8_t*)raw;
+    if (slack) {
+        uint8_t* aligned = (uint8_t*)(((uintptr_t)base + HUGE_PAGE - 1) & ~(uintptr_t)(HUGE_PAGE - 1));
+        if (aligned > base) munmap(base, aligned - base);
+        if (aligned + want < base + want + slack) munmap(aligned + want, base + want + slack - (aligned + want));
+        base = aligned;
+#ifdef MADV_HUGEPAGE
+        madvise(base, want, MADV_HUGEPAGE);
+#endif
+    }
+
+    bool locked = false;
+    if (m_locked) {
+        locked = mlock(base, want) == 0;
+        if (locked) m_stats.bytesLocked += want;
+        else m_stats.lockFailures++;
+    }
+    m_blocks[base] = { m_locked, locked };
+    m_stats.bytesMapped += want;
+    block = want;
+    return base;
+}
+
+void ScanArena::Release(void* base, size_t block) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // Blocks mapped under the other lock setting are dropped rather than kept
+    auto it = m_blocks.find(base);
+    const bool wrongKind = it != m_blocks.end() && it->second.wantLocked != m_locked;
+    if (wrongKind || m_stats.bytesFree + block > MAX_FREE_BYTES) {
+        Unmap(base, block);
+        return;
+    }
+    m_free.insert({ block, base });
+    m_stats.bytesFree += block;
+}
+
+// Caller holds m_mutex
+void ScanArena::Unmap(void* base, size_t block) {
+    auto it = m_blocks.find(base);
+    if (it != m_blocks.end()) {
+        if (it->second.locked) m_stats.bytesLocked -= block;
+        m_blocks.erase(it);
+    }
+    munmap(base, block); // Unlocks too
+    m_stats.bytesMapped -= block;
+}
+
+void ScanArena::SetLocked(bool locked) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (locked == m_locked) return;
+    m_locked = locked;
+    for (const auto& block : m_free) Unmap(block.second, block.first);
+    m_free.clear();
+    m_stats.bytesFree = 0;
+}
+
+bool ScanArena::IsLocked() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_locked;
+}
+
+void ScanArena::Trim() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& block : m_free) Unmap(block.second, block.first);
+    m_free.clear();
+    m_stats.bytesFree = 0;
+}
+
+ArenaStats ScanArena::Stats() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
@@ -0,0 +1,196 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Scan kernel registry: one specialized function per value type x operator x stride.
+// The kernel is picked once per job, so the inner loop carries no type or operator branch.
+
+// Scan operators
+enum ScanOp {
+    OP_EQ,    // v == a
+    OP_NE,    // v != a
+    OP_LT,    // v < a
+    OP_GT,    // v > a
+    OP_RANGE, // a <= v <= b
+    OP_MASK,  // (bits(v) & b) == a
+    OP_COUNT
+};
+
+// Operand bits, little-endian in the low bytes like the value itself
+struct ScanOperand {
+    uint64_t a = 0;
+    uint64_t b = 0; // Upper bound for OP_RANGE, mask for OP_MASK
+};
+
+// Scans every 'stride'-aligned slot of buf[0, len) and writes the byte offset of each
+// match to 'out', which must hold len / stride + 1 entries. Returns the match count.
+typedef size_t (*ScanKernelFn)(const uint8_t* buf, size_t len, const ScanOperand& operand, uint32_t* out);
+
+static const size_t SCAN_STRIDE_COUNT = 4; // Strides 1, 2, 4, 8
+
+// Compare-to-previous operators: current value against the one captured by the last pass
+enum CompareOp {
+    CMP_EQ,    // Unchanged
+    CMP_NE,    // Changed
+    CMP_GT,    // Increased
+    CMP_LT,    // Decreased
+    CMP_DELTA, // a <= cur - prev <= b
+    CMP_COUNT
+};
+
+// Compares 'count' packed values of 'cur' with the same rows of 'prev' and writes the
+// index of each matching row to 'out' (count + 1 entries). Returns the match count.
+typedef size_t (*CompareKernelFn)(const uint8_t* cur, const uint8_t* prev, size_t count, const ScanOperand& operand, uint32_t* out);
+
+template <typename T, int OP>
+static inline bool ScanMatch(T v, T a, T b, uint64_t bits, uint64_t ma, uint64_t mb) {
+    switch (OP) {
+        case OP_EQ: return v == a;
+        case OP_NE: return v != a;
+        case OP_LT: return v < a;
+        case OP_GT: return v > a;
+        case OP_RANGE: return v >= a && v <= b;
+        case OP_MASK: return (bits & mb) == ma;
+    }
+    return false;
+}
+
+// Blocks of 64 slots: the compare loop only builds a bitmask (no stores, no branches, so
+// the compiler vectorizes it), and set bits are extracted afterwards. Blocks without a
+// match, the common case, cost nothing beyond the compare.
+template <typename T, int OP, size_t STRIDE>
+size_t ScanKernel(const uint8_t* buf, size_t len, const ScanOperand& operand, uint32_t* out) {
+    if (len < sizeof(T)) return 0;
+    T a, b;
+    uint64_t ma = operand.a, mb = operand.b;
+    memcpy(&a, &ma, sizeof(T));
+    memcpy(&b, &mb, sizeof(T));
+
+    const size_t slots = (len - sizeof(T)) / STRIDE + 1;
+    size_t n = 0;
+    for (size_t base = 0; base < slots; base += 64) {
+        const size_t lim = slots - base < 64 ? slots - base : 64;
+        const uint8_t* p = buf + base * STRIDE;
+        uint64_t mask = 0;
+        for (size_t j = 0; j < lim; j++) {
+            T v;
+            memcpy(&v, p + j * STRIDE, sizeof(T));
+            uint64_t bits = 0;
+            if (OP == OP_MASK) memcpy(&bits, &v, sizeof(T));
+            mask |= (uint64_t)ScanMatch<T, OP>(v, a, b, bits, ma, mb) << j;
+        }
+        while (mask) {
+            size_t j = (size_t)__builtin_ctzll(mask);
+            out[n++] = (uint32_t)((base + j) * STRIDE);
+            mask &= mask - 1;
+        }
+    }
+    return n;
+}
+
+// Integer deltas wrap like the target's own arithmetic instead of overflowing
+template <typename T>
+static inline T ScanDelta(T cur, T prev) {
+    return std::is_integral<T>::value ? (T)((uint64_t)cur - (uint64_t)prev) : (T)(cur - prev);
+}
+
+template <typename T, int OP>
+static inline bool CompareMatch(T cur, T prev, T a, T b) {
+    switch (OP) {
+        case CMP_EQ: return cur == prev;
+        case CMP_NE: return cur != prev;
+        case CMP_GT: return cur > prev;
+        case CMP_LT: return cur < prev;
+        case CMP_DELTA: { T d = ScanDelta(cur, prev); return d >= a && d <= b; }
+    }
+    return false;
+}
+
+// Same block-of-64 bitmask scheme as ScanKernel, over two packed columns
+template <typename T, int OP>
+size_t CompareKernel(const uint8_t* cur, const uint8_t* prev, size_t count, const ScanOperand& operand, uint32_t* out) {
+    T a, b;
+    memcpy(&a, &operand.a, sizeof(T));
+    memcpy(&b, &operand.b, sizeof(T));
+
+    size_t n = 0;
+    for (size_t base = 0; base < count; base += 64) {
+        const size_t lim = count - base < 64 ? count - base : 64;
+        uint64_t mask = 0;
+        for (size_t j = 0; j < lim; j++) {
+            T c, p;
+            memcpy(&c, cur + (base + j) * sizeof(T), sizeof(T));
+            memcpy(&p, prev + (base + j) * sizeof(T), sizeof(T));
+            mask |= (uint64_t)CompareMatch<T, OP>(c, p, a, b) << j;
+        }
+        while (mask) {
+            size_t j = (size_t)__builtin_ctzll(mask);
+            out[n++] = (uint32_t)(base + j);
+            mask &= mask - 1;
+        }
+    }
+    return n;
+}
+
+// Registry over a list of value types; a type is addressed by its index in the list
+template <typename... Ts>
+struct ScanKernelRegistry {
+    static const size_t TYPE_COUNT = sizeof...(Ts);
+
+    static ScanKernelFn Get(size_t typeIndex, int op, size_t stride) {
+        size_t s = stride >= 8 ? 3 : stride >= 4 ? 2 : stride >= 2 ? 1 : 0;
+        if (typeIndex >= TYPE_COUNT || op < 0 || op >= OP_COUNT) return nullptr;
+        return Instance().fns[typeIndex][op][s];
+    }
+
+    static CompareKernelFn GetCompare(size_t typeIndex, int op) {
+        if (typeIndex >= TYPE_COUNT || op < 0 || op >= CMP_COUNT) return nullptr;
+        return Instance().cmp[typeIndex][op];
+    }
+
+private:
+    template <typename T, int OP>
+    static void FillStrides(ScanKernelFn* dst) {
+        dst[0] = &ScanKernel<T, OP, 1>;
+        dst[1] = &ScanKernel<T, OP, 2>;
+        dst[2] = &ScanKernel<T, OP, 4>;
+        dst[3] = &ScanKernel<T, OP, 8>;
+    }
+
+    template <typename T>
+    static void FillOps(ScanKernelFn (*dst)[SCAN_STRIDE_COUNT]) {
+        FillStrides<T, OP_EQ>(dst[OP_EQ]);
+        FillStrides<T, OP_NE>(dst[OP_NE]);
+        FillStrides<T, OP_LT>(dst[OP_LT]);
+        FillStrides<T, OP_GT>(dst[OP_GT]);
+        FillStrides<T, OP_RANGE>(dst[OP_RANGE]);
+        FillStrides<T, OP_MASK>(dst[OP_MASK]);
+    }
+
+    template <typename T>
+    static void FillCompare(CompareKernelFn* dst) {
+        dst[CMP_EQ] = &CompareKernel<T, CMP_EQ>;
+        dst[CMP_NE] = &CompareKernel<T, CMP_NE>;
+        dst[CMP_GT] = &CompareKernel<T, CMP_GT>;
+        dst[CMP_LT] = &CompareKernel<T, CMP_LT>;
+        dst[CMP_DELTA] = &CompareKernel<T, CMP_DELTA>;
+    }
+
+    struct Table {
+        ScanKernelFn fns[sizeof...(Ts)][OP_COUNT][SCAN_STRIDE_COUNT];
+        CompareKernelFn cmp[sizeof...(Ts)][CMP_COUNT];
+        Table() {
+            size_t i = 0, j = 0;
+            // Expands to one FillOps / FillCompare call per type, in list order
+            int expand[] = { (FillOps<Ts>(fns[i++]), FillCompare<Ts>(cmp[j++]), 0)... };
+            (void)expand;
+        }
+    };
+
+    static const Table& Instance() {
+        static const Table table;
+        return table;
+    }
+};
@@ -0,0 +1,149 @@
+#include "MemoryTool.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+// ==============================================================================================
+// Value Cache
+// ==============================================================================================
+
+void ValueCache::SetRows(const ADDRESS* addrs, const int* types, size_t count) {
+    count = std::min(count, MAX_ROWS);
+    bool changed = false;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        bool same = m_rows.size() == count;
+        for (size_t i = 0; same && i < count; i++) {
+            same = m_rows[i].first == addrs[i] && m_rows[i].second == types[i];
+        }
+        if (!same) {
+            m_rows.resize(count);
+            for (size_t i = 0; i < count; i++) m_rows[i] = { addrs[i], types[i] };
+            m_rowsDirty = changed = true;
+        }
+    }
+    if (!m_running.exchange(true)) {
+        if (m_thread.joinable()) m_thread.join();
+        m_thread = std::thread(&ValueCache::RefreshLoop, this);
+    }
+    if (changed) m_rowsChanged.notify_one();
+}
+
+size_t ValueCache::Read(Value* out, size_t max) const {
+    uint64_t words[WORDS];
+    for (;;) {
+        uint32_t seq = m_seq.load(std::memory_order_acquire);
+        if (seq & 1) {
+            std::this_thread::yield();
+            continue;
+        }
+        size_t count = std::min<size_t>(m_count.load(std::memory_order_relaxed), max);
+        for (size_t i = 0; i < count; i++) {
+            for (size_t w = 0; w < WORDS; w++) words[w] = m_words[i * WORDS + w].load(std::memory_order_relaxed);
+            memcpy(&out[i], words, sizeof(Value));
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (m_seq.load(std::memory_order_relaxed) == seq) return count;
+    }
+}
+
+const ValueCache::Value* ValueCache::Find(const Value* values, size_t count, ADDRESS addr, int type) {
+    const Value* it = std::lower_bound(values, values + count, std::make_pair(addr, type),
+        [](const Value& v, const std::pair<ADDRESS, int>& key) {
+            return v.addr != key.first ? v.addr < key.first : v.type < key.second;
+        });
+    return it != values + count && it->addr == addr && it->type == type ? it : nullptr;
+}
+
+void ValueCache::SetRate(int hz) {
+    m_rateHz = std::max(1, std::min(hz, MAX_RATE));
+}
+
+void ValueCache::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_running = false;
+    }
+    m_rowsChanged.notify_one();
+    if (m_thread.joinable()) m_thread.join();
+}
+
+void ValueCache::Publish(const std::vector<Value>& values) {
+    uint32_t seq = m_seq.load(std::memory_order_relaxed);
+    m_seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    uint64_t words[WORDS];
+    for (size_t i = 0; i < values.size(); i++) {
+        memcpy(words, &values[i], sizeof(Value));
+        for (size_t w = 0; w < WORDS; w++) m_words[i * WORDS + w].store(words[w], std::memory_order_relaxed);
+    }
+    m_count.store((uint32_t)values.size(), std::memory_order_relaxed);
+    m_seq.store(seq + 2, std::memory_order_release);
+}
+
+// Rows are sorted and coalesced into spans only when they change; a round is one batched read
+// of the spans and a FormatValue per row into the staging copy that gets published. The
+// listener hears of a round only when some text changed, so still values cost the UI nothing.
+void ValueCache::RefreshLoop() {
+    std::vector<std::pair<ADDRESS, int>> rows;
+    std::vector<ReadSpan> spans;
+    std::vector<kpm_read_span> reads;
+    std::vector<uint8_t> buffer;
+    std::vector<Value> values;
+    bool changed = false; // Some text differs from the last round's
+    auto deadline = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running) {
+        if (m_rowsDirty) {
+            rows = m_rows;
+            m_rowsDirty = false;
+            lock.unlock();
+            std::sort(rows.begin(), rows.end());
+            rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+            spans = BuildReadSpans(rows.size(),
+                [&](size_t i) { return rows[i].first; },
+                [&](size_t i) { return std::max<size_t>(MemoryTool::GetTypeInfo(rows[i].second).size, 1); });
+            buffer.assign(spans.empty() ? 0 : spans.back().bufOffset + spans.back().len, 0);
+            reads.resize(spans.size());
+            for (size_t s = 0; s < spans.size(); s++) reads[s] = { spans[s].addr, buffer.data() + spans[s].bufOffset, spans[s].len, 0 };
+            values.assign(rows.size(), Value());
+            changed = true;
+            lock.lock();
+        }
+        lock.unlock();
+
+        auto start = std::chrono::steady_clock::now();
+        for (auto& r : reads) r.got = 0;
+        m_kpm.read_spans(reads.data(), reads.size());
+        for (size_t s = 0; s < spans.size(); s++) {
+            const ReadSpan& span = spans[s];
+            for (uint32_t k = 0; k < span.count; k++) {
+                size_t i = span.first + k;
+                Value& v = values[i];
+                v.addr = rows[i].first;
+                v.type = rows[i].second;
+                uint32_t at = (uint32_t)(v.addr - span.addr);
+                size_t size = MemoryTool::GetTypeInfo(v.type).size;
+                char text[sizeof(v.text)];
+                v.valid = size && reads[s].got >= at + size;
+                if (v.valid) MemoryTool::FormatValue(buffer.data() + span.bufOffset + at, v.type, text, sizeof(text));
+                else snprintf(text, sizeof(text), "?");
+                if (strcmp(text, v.text) != 0) {
+                    memcpy(v.text, text, sizeof(text));
+                    changed = true;
+                }
+            }
+        }
+        Publish(values);
+        if (changed && m_listener) m_listener();
+        changed = false;
+        auto end = std::chrono::steady_clock::now();
+        m_roundNs = std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+
+        deadline += std::chrono::nanoseconds(1000000000LL / std::max(1, m_rateHz.load()));
+        if (deadline < end) deadline = end; // Behind: no catching up
+        lock.lock();
+        m_rowsChanged.wait_until(lock, deadline, [&] { return !m_running || m_rowsDirty; });
+    }
+}
@@ -13,6 +13,10 @@
 #include <errno.h>
 #include <iostream>
 #include <stdint.h>
+#include <sys/uio.h>
+#include <vector>
+#include <atomic>
+#include "ScanKernels.h"
 
 #define TAG "KPMClient"
 #define LOGD(fmt, ...) printf("[%s] [D] " fmt "\n", TAG, ##__VA_ARGS__)
@@ -32,6 +36,27 @@
 
 #define CMD_READ 0
 #define CMD_WRITE 1
+#define CMD_SEARCH 2
+#define CMD_SEARCH_BATCH 3
+#define CMD_SEARCH_EX 4 // CMD_SEARCH with operator fields appended to the config
+
+// Search operators
+#define SEARCH_OP_EQ 0      // v == value
+#define SEARCH_OP_RANGE 1   // value <= v <= value2
+#define SEARCH_OP_MASK_EQ 2 // (v & value2) == value
+#define SEARCH_OP_NE 3      // v != value
+
+// Search flags
+#define SEARCH_FLAG_FLOAT 1  // Compare as float (val_size 4) or double (val_size 8)
+#define SEARCH_FLAG_SIGNED 2 // Integer range compares are signed
+
+// Memory access backends
+#define BACKEND_KPM 0  // prctl hook of the kernel module
+#define BACKEND_USER 1 // process_vm_readv/writev, works on any Linux with ptrace access
+
+#define KPM_SEARCH_SLICE (512 * 1024) // Default per-call span of the single-region search
+#define KPM_SEARCH_SLICE_MIN (16 * 1024) // Floor of the adaptive slice in dense areas
+#define MAX_KERNEL_RES 2048           // Result cap of the single-region search
 
 struct kpm_cmd {
     int pid;
@@ -41,25 +66,118 @@ struct kpm_cmd {
     uint64_t data; // User pointer
 };
 
+// One piece of a vectored read; 'got' receives the bytes read, 0 if the span is unreadable
+struct kpm_read_span {
+    uint64_t addr;
+    void* buf;
+    uint32_t len;
+    uint32_t got;
+};
+
+// Batch search ABI, shared with the driver
+struct kpm_search_region {
+    uint64_t start;
+    uint64_t end;
+};
+
+// Continuation point of a batch search. Zero-initialize to start at the first region;
+// when a call returns with done == 0, pass the same cursor back to continue.
+struct kpm_search_cursor {
+    uint32_t region;
+    uint32_t done;
+    uint64_t addr; // Next address to scan inside 'region', 0 = region start
+};
+
+struct kpm_search_query {
+    uint64_t value;
+    uint32_t val_size;
+    uint32_t op = SEARCH_OP_EQ;
+    uint32_t flags = 0;
+    uint64_t value2 = 0; // Upper bound for RANGE, mask for MASK_EQ
+};
+
+// Kernels for the user-space emulation, indexed by kpm_kernel_type()
+typedef ScanKernelRegistry<uint8_t, uint16_t, uint32_t, uint64_t, int8_t, int16_t, int32_t, int64_t, float, double> KPMKernels;
+
+static inline ScanKernelFn kpm_select_kernel(const kpm_search_query& q, uint64_t step) {
+    size_t typeIndex;
+    switch (q.val_size) {
+        case 1: typeIndex = 0; break;
+        case 2: typeIndex = 1; break;
+        case 4: typeIndex = 2; break;
+        case 8: typeIndex = 3; break;
+        default: return nullptr;
+    }
+    if (q.flags & SEARCH_FLAG_FLOAT) {
+        if (q.val_size == 4) typeIndex = 8;
+        else if (q.val_size == 8) typeIndex = 9;
+        else return nullptr;
+    } else if (q.flags & SEARCH_FLAG_SIGNED) {
+        typeIndex += 4;
+    }
+    int op;
+    switch (q.op) {
+        case SEARCH_OP_EQ: op = OP_EQ; break;
+        case SEARCH_OP_RANGE: op = OP_RANGE; break;
+        case SEARCH_OP_MASK_EQ: op = OP_MASK; break;
+        case SEARCH_OP_NE: op = OP_NE; break;
+        default: return nullptr;
+    }
+    return KPMKernels::Get(typeIndex, op, (size_t)step);
+}
+
 class KPMClient {
 private:
     int target_pid = -1;
+    int backend = BACKEND_KPM;
+    int batch_support = -1; // -1 unknown, 0 driver lacks CMD_SEARCH_BATCH, 1 supported
+    int ops_support = -1;   // -1 unknown, 0 driver lacks CMD_SEARCH_EX, 1 supported
+    uint32_t batch_rejected = 0; // Bit op * 4 + flags: the batch command answered EOPNOTSUPP for it
+
+    static uint32_t batch_query_bit(const kpm_search_query& q) {
+        return q.op < 8 && q.flags < 4 ? 1u << (q.op * 4 + q.flags) : 0;
+    }
+    std::vector<uint8_t> scan_buf; // Scratch for the user-space search emulation
+    std::vector<uint32_t> scan_hits;
+
+    int call_driver(struct kpm_cmd* cmd) {
+        int ret;
+        int retries = 0;
+        do {
+            ret = syscall(SYS_prctl, MAGIC_CODE, cmd, 0, 0, 0);
+            retries++;
+        } while (ret < 0 && errno == EINTR && retries < 100);
+        syscall_count++;
+        return ret;
+    }
 
 public:
-    int last_error = 0;
+    std::atomic<int> last_error{0}; // errno of the last failed call; reader, sampler and job threads all set it
+    std::atomic<uint64_t> syscall_count{0}; // Driver / vm_readv round trips, for scan reports; reader threads count too
+    uint64_t search_resumptions = 0; // Slices resumed after hitting MAX_KERNEL_RES
+    uint64_t search_slice_size = KPM_SEARCH_SLICE; // Adapts down in dense areas, back up in sparse ones
+    uint64_t search_slice_max = KPM_SEARCH_SLICE;  // Where search_slice_size grows back to; set by the chunk autotuner
     KPMClient() : target_pid(-1), last_error(0) {}
 
-    bool init(int pid) {
+    bool init(int pid, int backend_type = BACKEND_KPM) {
         if (pid <= 0) return false;
         target_pid = pid;
+        backend = backend_type;
         last_error = 0;
-        LOGD("Initialized for PID %d (Mode: %s-bit, Magic: 0x%X)", target_pid, (KPM_IS_64BIT ? "64" : "32"), MAGIC_CODE);
+        LOGD("Initialized for PID %d (Mode: %s-bit, Magic: 0x%X, Backend: %s)", target_pid, (KPM_IS_64BIT ? "64" : "32"), MAGIC_CODE,
+             (backend == BACKEND_USER ? "user" : "kpm"));
         return true;
     }
 
     int get_last_error() { return last_error; }
+    int get_backend() { return backend; }
+    int get_pid() { return target_pid; }
+    // Searches go through search_slice, so search_slice_max matters (once the batch probe has run)
+    bool searches_in_slices() const { return backend == BACKEND_USER || batch_support == 0; }
 
     bool check_driver() {
+        if (backend == BACKEND_USER) return true;
+
         struct kpm_cmd cmd;
         int dummy_src = 12345;
         int dummy_dst = 0;
@@ -70,12 +188,7 @@ public:
         cmd.len = sizeof(int); 
         cmd.data = (uint64_t)&dummy_dst;
         
-        int ret;
-        int retries = 0;
-        do {
-            ret = syscall(SYS_prctl, MAGIC_CODE, &cmd, 0, 0, 0);
-            retries++;
-        } while (ret < 0 && errno == EINTR && retries < 100); 
+        int ret = call_driver(&cmd);
         
         if (ret == 0) return true;
         
@@ -161,6 +274,19 @@ public:
 
     size_t read_raw(uint64_t address, void* buffer, size_t size) {
         if (target_pid <= 0) return 0;
+
+        if (backend == BACKEND_USER) {
+            struct iovec local = { buffer, size };
+            struct iovec remote = { (void*)(uintptr_t)address, size };
+            ssize_t ret = process_vm_readv(target_pid, &local, 1, &remote, 1, 0);
+            syscall_count++;
+            if (ret < 0) {
+                last_error = errno;
+                return 0;
+            }
+            last_error = 0;
+            return (size_t)ret;
+        }
         
         struct kpm_cmd cmd;
         cmd.pid = target_pid;
@@ -169,12 +295,7 @@ public:
         cmd.len = (uint64_t)size;
         cmd.data = (uint64_t)buffer;
 
-        int ret;
-        int retries = 0;
-        do {
-            ret = syscall(SYS_prctl, MAGIC_CODE, &cmd, 0, 0, 0);
-            retries++;
-        } while (ret < 0 && errno == EINTR && retries < 100);
+        int ret = call_driver(&cmd);
 
         if (ret < 0) {
             last_error = errno;
@@ -185,9 +306,64 @@ public:
         return (size_t)ret;
     }
 
+    // Reads many spans at once: one process_vm_readv per IOV_MAX spans on the user backend (a
+    // failing span ends that call, so the rest are retried after it), one driver call per span
+    // otherwise. Returns how many spans were read in full.
+    size_t read_spans(kpm_read_span* spans, size_t count) {
+        size_t complete = 0;
+        if (backend != BACKEND_USER) {
+            for (size_t i = 0; i < count; i++) {
+                spans[i].got = (uint32_t)read_raw(spans[i].addr, spans[i].buf, spans[i].len);
+                if (spans[i].got == spans[i].len) complete++;
+            }
+            return complete;
+        }
+        if (target_pid <= 0) return 0;
+
+        static const size_t MAX_IOV = 1024; // UIO_MAXIOV
+        struct iovec local[MAX_IOV], remote[MAX_IOV];
+        size_t i = 0;
+        while (i < count) {
+            size_t n = count - i < MAX_IOV ? count - i : MAX_IOV;
+            for (size_t k = 0; k < n; k++) {
+                local[k] = { spans[i + k].buf, spans[i + k].len };
+                remote[k] = { (void*)(uintptr_t)spans[i + k].addr, spans[i + k].len };
+            }
+            ssize_t ret = process_vm_readv(target_pid, local, n, remote, n, 0);
+            syscall_count++;
+            size_t left = ret > 0 ? (size_t)ret : 0;
+            size_t k = 0;
+            for (; k < n && left >= spans[i + k].len; k++) {
+                spans[i + k].got = spans[i + k].len;
+                left -= spans[i + k].len;
+                complete++;
+            }
+            if (k < n) {
+                // The call stopped inside span k: keep what arrived and go on after it
+                spans[i + k].got = (uint32_t)left;
+                k++;
+            }
+            i += k;
+        }
+        return complete;
+    }
+
     size_t write_raw(uint64_t address, const void* buffer, size_t size) {
          if (target_pid <= 0) return 0;
 
+        if (backend == BACKEND_USER) {
+            struct iovec local = { (void*)buffer, size };
+            struct iovec remote = { (void*)(uintptr_t)address, size };
+            ssize_t ret = process_vm_writev(target_pid, &local, 1, &remote, 1, 0);
+            syscall_count++;
+            if (ret < 0) {
+                last_error = errno;
+                return 0;
+            }
+            last_error = 0;
+            return (size_t)ret;
+        }
+
         struct kpm_cmd cmd;
         cmd.pid = target_pid;
         cmd.op = CMD_WRITE;
@@ -195,12 +371,7 @@ public:
         cmd.len = (uint64_t)size;
         cmd.data = (uint64_t)buffer; 
 
-        int ret;
-        int retries = 0;
-        do {
-            ret = syscall(SYS_prctl, MAGIC_CODE, &cmd, 0, 0, 0);
-            retries++;
-        } while (ret < 0 && errno == EINTR && retries < 100);
+        int ret = call_driver(&cmd);
 
         if (ret < 0) {
             last_error = errno;
@@ -218,39 +389,61 @@ public:
     // results: buffer to store found addresses (must be large enough for max_results * 8)
     int search_kernel(uint64_t addr, uint64_t len, uint64_t value, int val_size, 
                       uint64_t* result_buffer, int max_results) {
+        kpm_search_query query;
+        query.value = value;
+        query.val_size = (uint32_t)val_size;
+        return search_slice(addr, len, query, result_buffer, max_results);
+    }
+
+    // Single-region search with any operator. Plain equality keeps using CMD_SEARCH so
+    // older drivers work; everything else needs CMD_SEARCH_EX (see supports_search_ops).
+    int search_slice(uint64_t addr, uint64_t len, const kpm_search_query& query,
+                     uint64_t* result_buffer, int max_results) {
         if (target_pid <= 0) return 0;
+
+        if (backend == BACKEND_USER) {
+            return (int)search_user(addr, addr + len, query, result_buffer, (size_t)max_results, nullptr);
+        }
+
+        bool extended = query.op != SEARCH_OP_EQ || query.flags != 0;
+        if (extended && !supports_search_ops()) {
+            LOGE("search_slice: driver has no CMD_SEARCH_EX, op %u not available", query.op);
+            return 0;
+        }
         
         struct kpm_cmd cmd;
         
-        // Matches kernel layout: { u64 value; u32 val_size; u32 max_results; u64 count_ptr; u64 buf_ptr; }
+        // Matches kernel layout: { u64 value; u32 val_size; u32 max_results; u64 count_ptr; u64 buf_ptr;
+        //                          u32 op; u32 flags; u64 value2; }  (last three only read for CMD_SEARCH_EX)
         struct __attribute__((packed)) {
             uint64_t val;
             uint32_t val_size;
             uint32_t max_res;
             uint64_t count_ptr;
             uint64_t buf_ptr;
+            uint32_t op;
+            uint32_t flags;
+            uint64_t val2;
         } config;
         
         uint32_t found_count = 0;
         
-        config.val = value;
-        config.val_size = (uint32_t)val_size;
+        config.val = query.value;
+        config.val_size = query.val_size;
         config.max_res = (uint32_t)max_results;
         config.count_ptr = (uint64_t)&found_count;
         config.buf_ptr = (uint64_t)result_buffer;
+        config.op = query.op;
+        config.flags = query.flags;
+        config.val2 = query.value2;
         
         cmd.pid = target_pid;
-        cmd.op = 2; // CMD_SEARCH
+        cmd.op = extended ? CMD_SEARCH_EX : CMD_SEARCH;
         cmd.addr = addr;
         cmd.len = len;
         cmd.data = (uint64_t)&config;
         
-        int ret;
-        int retries = 0;
-        do {
-            ret = syscall(SYS_prctl, MAGIC_CODE, &cmd, 0, 0, 0);
-            retries++;
-        } while (ret < 0 && errno == EINTR && retries < 100);
+        int ret = call_driver(&cmd);
 
         if (ret < 0) {
             return 0; 
@@ -259,6 +452,209 @@ public:
         return (int)found_count;
     }
 
+    // Whether range / mask / not-equal / float queries can run on the driver side.
+    // Probed once with CMD_SEARCH_EX against a known buffer in our own process.
+    bool supports_search_ops() {
+        if (backend == BACKEND_USER) return true;
+        if (ops_support >= 0) return ops_support == 1;
+
+        static const int32_t probe[8] = { 5, 10, 15, 20, 25, 30, 35, 40 };
+        uint64_t hits[8] = {};
+        uint32_t found_count = 0;
+        struct __attribute__((packed)) {
+            uint64_t val;
+            uint32_t val_size;
+            uint32_t max_res;
+            uint64_t count_ptr;
+            uint64_t buf_ptr;
+            uint32_t op;
+            uint32_t flags;
+            uint64_t val2;
+        } config = { 12, 4, 8, (uint64_t)&found_count, (uint64_t)hits, SEARCH_OP_RANGE, SEARCH_FLAG_SIGNED, 31 };
+
+        struct kpm_cmd cmd;
+        cmd.pid = getpid();
+        cmd.op = CMD_SEARCH_EX;
+        cmd.addr = (uint64_t)probe;
+        cmd.len = sizeof(probe);
+        cmd.data = (uint64_t)&config;
+
+        int ret = call_driver(&cmd);
+        // 15, 20, 25, 30 are in [12, 31]; an old driver either rejects the op or treats it as equality (0 hits)
+        ops_support = (ret >= 0 && found_count == 4 && hits[0] == (uint64_t)&probe[2]) ? 1 : 0;
+        LOGD("Driver-side search operators: %s", ops_support ? "supported" : "not supported, using user-side scan");
+        return ops_support == 1;
+    }
+
+    // Multi-region search: scans 'regions' in order from 'cursor' and fills up to
+    // 'max_results' addresses. Returns the number written; cursor.done is set once
+    // every region has been covered, otherwise call again with the same cursor.
+    // A driver failure that emulation cannot get around (the target exited, a bad buffer)
+    // also sets cursor.done, and stores the errno in *error.
+    size_t search_batch(const kpm_search_region* regions, uint32_t region_count, const kpm_search_query& query,
+                        uint64_t* result_buffer, size_t max_results, kpm_search_cursor& cursor, int* error = nullptr) {
+        if (error) *error = 0;
+        if (target_pid <= 0 || cursor.region >= region_count) {
+            cursor.done = 1;
+            return 0;
+        }
+
+        if (backend == BACKEND_KPM && batch_support != 0 && !(batch_rejected & batch_query_bit(query))) {
+            // Matches kernel layout: { u64 value; u32 val_size; u32 region_count; u64 regions_ptr;
+            //                          u64 max_results; u64 count_ptr; u64 buf_ptr; u64 cursor_ptr;
+            //                          u32 op; u32 flags; u64 value2; }
+            // A driver that cannot evaluate 'op' must fail with EOPNOTSUPP.
+            struct __attribute__((packed)) {
+                uint64_t val;
+                uint32_t val_size;
+                uint32_t region_count;
+                uint64_t regions_ptr;
+                uint64_t max_res;
+                uint64_t count_ptr;
+                uint64_t buf_ptr;
+                uint64_t cursor_ptr;
+                uint32_t op;
+                uint32_t flags;
+                uint64_t val2;
+            } config;
+
+            uint64_t found_count = 0;
+            config.val = query.value;
+            config.val_size = query.val_size;
+            config.region_count = region_count;
+            config.regions_ptr = (uint64_t)regions;
+            config.max_res = max_results;
+            config.count_ptr = (uint64_t)&found_count;
+            config.buf_ptr = (uint64_t)result_buffer;
+            config.cursor_ptr = (uint64_t)&cursor;
+            config.op = query.op;
+            config.flags = query.flags;
+            config.val2 = query.value2;
+
+            struct kpm_cmd cmd;
+            cmd.pid = target_pid;
+            cmd.op = CMD_SEARCH_BATCH;
+            cmd.addr = 0;
+            cmd.len = 0;
+            cmd.data = (uint64_t)&config;
+
+            int ret = call_driver(&cmd);
+            if (ret >= 0) {
+                batch_support = 1;
+                return (size_t)found_count;
+            }
+            if (errno != EINVAL && errno != ENOSYS && errno != EOPNOTSUPP) {
+                last_error = errno;
+                if (error) *error = errno;
+                LOGE("Batch search failed (errno %d: %s)", errno, strerror(errno));
+                cursor.done = 1; // Retrying the same call would fail the same way
+                return 0;
+            }
+            bool extended = query.op != SEARCH_OP_EQ || query.flags != 0;
+            if (!extended && errno != EOPNOTSUPP) {
+                // A plain equality search rejected: older driver without CMD_SEARCH_BATCH, emulate it from now on
+                LOGD("Driver has no batch search (errno %d), emulating", errno);
+                batch_support = 0;
+            } else if (errno == EOPNOTSUPP) {
+                // Only this operator is unsupported: later searches with it skip the failing call
+                batch_rejected |= batch_query_bit(query);
+                LOGD("Batch search does not support op %u flags %u, emulating it from now on", query.op, query.flags);
+            } else {
+                // An extended op rejected some other way; later searches still try the batch command
+                LOGD("Batch search rejected op %u flags %u (errno %d), emulating this search", query.op, query.flags, errno);
+            }
+        }
+
+        return search_batch_emulated(regions, region_count, query, result_buffer, max_results, cursor);
+    }
+
+    // Batch search built from the per-slice primitives of the active backend
+    size_t search_batch_emulated(const kpm_search_region* regions, uint32_t region_count, const kpm_search_query& query,
+                                 uint64_t* result_buffer, size_t max_results, kpm_search_cursor& cursor) {
+        size_t found = 0;
+        if (search_slice_size > search_slice_max) search_slice_size = search_slice_max;
+        while (cursor.region < region_count) {
+            const kpm_search_region& r = regions[cursor.region];
+            uint64_t curr = cursor.addr ? cursor.addr : r.start;
+
+            if (backend == BACKEND_USER) {
+                found += search_user(curr, r.end, query, result_buffer + found, max_results - found, &curr);
+            } else {
+                while (curr < r.end && found < max_results) {
+                    uint64_t slice = r.end - curr < search_slice_size ? r.end - curr : search_slice_size;
+                    size_t room = max_results - found;
+                    int cap = room < MAX_KERNEL_RES ? (int)room : MAX_KERNEL_RES;
+                    int n = search_slice(curr, slice, query, result_buffer + found, cap);
+                    found += n;
+                    if (n == cap) {
+                        // The driver stopped at its result cap, so the rest of the slice is unscanned.
+                        // Resume right after the last hit; every call still yields 'cap' hits, so dense
+                        // values cost O(hits / cap) extra calls and the scan stays linear.
+                        curr = result_buffer[found - 1] + search_step(query.val_size);
+                        if (found == max_results) break; // Caller's buffer is full, cursor takes over
+                        search_resumptions++;
+                        // Dense area: smaller slices overflow less often
+                        if (search_slice_size > KPM_SEARCH_SLICE_MIN) search_slice_size /= 2;
+                        continue;
+                    }
+                    curr += slice;
+                    if (search_slice_size < search_slice_max && (uint64_t)n < MAX_KERNEL_RES / 4) search_slice_size *= 2;
+                }
+            }
+
+            if (curr >= r.end) {
+                cursor.region++;
+                cursor.addr = 0;
+            } else {
+                cursor.addr = curr;
+            }
+            if (found >= max_results) break;
+        }
+        cursor.done = cursor.region >= region_count;
+        return found;
+    }
+
+    // Stride of the search scan: natural alignment, capped at 4 like the driver
+    static uint64_t search_step(uint32_t val_size) {
+        return val_size > 4 ? 4 : val_size;
+    }
+
+    // User-space search over [start, end): reads slices through read_raw and compares in place.
+    // Stops early when 'max_results' is reached, leaving the resume address in *next.
+    size_t search_user(uint64_t start, uint64_t end, const kpm_search_query& query,
+                       uint64_t* result_buffer, size_t max_results, uint64_t* next) {
+        const uint64_t step = search_step(query.val_size);
+        ScanKernelFn kernel = kpm_select_kernel(query, step);
+        if (!kernel) {
+            if (next) *next = end;
+            return 0;
+        }
+        ScanOperand operand;
+        operand.a = query.value;
+        operand.b = query.value2;
+        const uint64_t span = search_slice_max;
+        if (scan_buf.size() < span) scan_buf.resize(span);
+        if (scan_hits.size() < span / step + 1) scan_hits.resize(span / step + 1);
+
+        size_t found = 0;
+        uint64_t curr = start;
+        while (curr < end) {
+            uint64_t slice = end - curr < span ? end - curr : span;
+            size_t got = read_raw(curr, scan_buf.data(), (size_t)slice);
+            size_t n = kernel(scan_buf.data(), got, operand, scan_hits.data());
+            for (size_t i = 0; i < n; i++) {
+                if (found == max_results) {
+                    if (next) *next = curr + scan_hits[i];
+                    return found;
+                }
+                result_buffer[found++] = curr + scan_hits[i];
+            }
+            curr += slice;
+        }
+        if (next) *next = end;
+        return found;
+    }
+
     template <typename T>
     T read(uint64_t address) {
         T data = {};
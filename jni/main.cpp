@@ -5,7 +5,9 @@
 #include <string>
 #include <algorithm>
 #include <cstring>
+#include <climits>
 #include <dirent.h>
+#include <signal.h>
 
 // Overlay Includes
 #include "draw.h" // drawBegin, drawEnd, initDraw, shutdown
@@ -14,19 +16,25 @@
 
 // MemoryTool Includes
 #include "MemoryTool.h"
+#include "Benchmarks.h"
+#include "RenderScheduler.h"
 
 using namespace std;
 
 // Global instance
 MemoryTool tool;
+RenderScheduler g_render;
 bool g_drawMenu = true;
+// Tabs drawn this frame whose content workers update; they decide which events wake the next one
+static bool g_resultsShown = false;
+static bool g_watchShown = false;
 char g_pkgNameBuffer[128] = "com.garena.game.kgvn"; // Default
 char g_searchValBuffer[128] = "";
 char g_refineValBuffer[128] = "";
 char g_writeValBuffer[128] = "";
 int g_selectedType = 0; // DWORD
 
-const char* DATA_TYPE_NAMES[] = { "DWORD", "FLOAT", "DOUBLE", "WORD", "BYTE", "QWORD" };
+const char* DATA_TYPE_NAMES[] = { "DWORD", "FLOAT", "DOUBLE", "WORD", "BYTE", "QWORD", "AUTO" };
 
 // Helper to get list of running apps
 std::vector<std::string> GetRunningPackages() {
@@ -162,7 +170,77 @@ void DrawVirtualKeyboard() {
 }
 
 
+// Progress of the running job with a cancel button, plus the outcome of the last one
+static char g_jobStatus[128] = "";
+
+void OnJobDone(const ScanJob& job) {
+    if (job.cancelled) snprintf(g_jobStatus, sizeof(g_jobStatus), "%s cancelled", job.label.c_str());
+    else snprintf(g_jobStatus, sizeof(g_jobStatus), "%s done: %d results", job.label.c_str(), tool.GetResultCount());
+}
+
+// Streaming scans (count, search & write) leave m_results alone; report the hit count instead
+void OnStreamJobDone(const ScanJob& job) {
+    if (job.cancelled) snprintf(g_jobStatus, sizeof(g_jobStatus), "%s cancelled", job.label.c_str());
+    else snprintf(g_jobStatus, sizeof(g_jobStatus), "%s done: %zu hits", job.label.c_str(), tool.GetLastScan().results);
+}
+
+// File save / load jobs report a FileLoadStatus (saves: OK or BAD_FILE) through this
+static std::atomic<int> g_fileStatus(FILE_LOAD_OK);
+
+void OnFileJobDone(const ScanJob& job) {
+    static const char* const messages[] = { "done", "done, but the target's maps changed since the save",
+                                            "refused: saved from another process instance", "failed: unreadable file" };
+    int status = g_fileStatus.load();
+    if (job.cancelled) snprintf(g_jobStatus, sizeof(g_jobStatus), "%s cancelled", job.label.c_str());
+    else snprintf(g_jobStatus, sizeof(g_jobStatus), "%s %s", job.label.c_str(), messages[status]);
+}
+
+void DrawJobStatus() {
+    if (tool.IsBusy()) {
+        uint64_t done = tool.m_progress.bytesDone;
+        uint64_t total = tool.m_progress.bytesTotal;
+        float fraction = total ? (float)((double)done / total) : 0.0f;
+        char label[64];
+        tool.GetRunningJobLabel(label, sizeof(label));
+        char overlay[96];
+        snprintf(overlay, sizeof(overlay), "%s  %.0f%%  (%llu hits)", label, fraction * 100.0f,
+                 (unsigned long long)tool.m_progress.hits);
+        ImGui::ProgressBar(fraction, ImVec2(-110, 0), overlay);
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel", ImVec2(100, 0))) tool.CancelJobs();
+    } else if (g_jobStatus[0]) {
+        ImGui::TextDisabled("%s", g_jobStatus);
+    }
+}
+
+// The tool's own memory against its budget; the breakdown folds out
+void DrawMemoryUsage() {
+    MemoryUsage usage = tool.GetMemoryUsage();
+    const double MB = 1024.0 * 1024.0;
+    char overlay[96];
+    if (usage.budget) snprintf(overlay, sizeof(overlay), "%.0f / %.0f MB", usage.Total() / MB, usage.budget / MB);
+    else snprintf(overlay, sizeof(overlay), "%.0f MB, no budget", usage.Total() / MB);
+    float fraction = usage.budget ? (float)std::min(1.0, (double)usage.Total() / usage.budget) : 0.0f;
+    bool open = ImGui::TreeNode("##MemoryUsage", "Tool Memory");
+    ImGui::SameLine();
+    ImGui::ProgressBar(fraction, ImVec2(-1, 0), overlay);
+    if (!open) return;
+
+    int budgetMb = (int)(tool.m_memoryBudget >> 20);
+    ImGui::SetNextItemWidth(150);
+    if (ImGui::InputInt("Budget (MB, 0 = none)", &budgetMb, 64, 256)) tool.m_memoryBudget = (size_t)std::max(0, budgetMb) << 20;
+    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Past this, caches are dropped and results move to files in %s.", tool.m_spillDir.c_str());
+    ImGui::TextDisabled("Results %.1f MB, history %.1f MB, saved sets %.1f MB, scan in progress %.1f MB", usage.results / MB,
+                        usage.history / MB, usage.savedSets / MB, usage.scanning / MB);
+    ImGui::TextDisabled("Page cache %.1f MB, scan buffers %.1f MB; spilled to disk %.1f MB; process RSS %.1f MB",
+                        usage.pageCache / MB, usage.scratch / MB, usage.spilled / MB, usage.processRss / MB);
+    RenderStats render = g_render.Stats();
+    ImGui::TextDisabled("Overlay %.1f fps, %.0f%% idle", render.fps, render.idlePct);
+    ImGui::TreePop();
+}
+
 void DrawMemoryToolWindow() {
+    g_resultsShown = g_watchShown = false;
     if (!g_drawMenu) return;
 
     // Use a slightly larger default window for tabs
@@ -174,6 +252,7 @@ void DrawMemoryToolWindow() {
             // Logic handled in DrawVirtualKeyboard
         }
         DrawVirtualKeyboard();
+        DrawMemoryUsage();
 
         if (ImGui::BeginTabBar("MainTabs")) {
             
@@ -205,8 +284,18 @@ void DrawMemoryToolWindow() {
                          ImGui::TextColored(ImVec4(1,0,0,1), "Driver Init: FAILED (Err: %d)", err);
                     }
                     
-                    // PID Status
-                    int pid = tool.getPID(g_pkgNameBuffer);
+                    // PID Status: getPID reads every /proc/*/cmdline, so it runs when the name changes or
+                    // once a second; in between a kill(pid, 0) tells whether the process is still there
+                    static char pidName[sizeof(g_pkgNameBuffer)] = "";
+                    static int pid = -1;
+                    static double pidCheckedAt = -1.0;
+                    double now = ImGui::GetTime();
+                    if (strcmp(pidName, g_pkgNameBuffer) != 0 || (pid > 0 && kill(pid, 0) != 0) ||
+                        (pid <= 0 && now - pidCheckedAt >= 1.0)) {
+                        strcpy(pidName, g_pkgNameBuffer);
+                        pid = tool.getPID(g_pkgNameBuffer);
+                        pidCheckedAt = now;
+                    }
                     if (pid > 0) ImGui::TextColored(ImVec4(0,1,0,1), "Connected PID: %d", pid);
                     else ImGui::TextColored(ImVec4(1,0.5,0,1), "Not Connected / Process Not Found");
                 ImGui::EndGroup();
@@ -241,9 +330,11 @@ void DrawMemoryToolWindow() {
                 CheckSetFocus(g_pkgNameBuffer, sizeof(g_pkgNameBuffer));
 
                 ImGui::Spacing();
+                static char connectError[256] = "";
                 if (ImGui::Button("CONNECT TO PROCESS", ImVec2(-1, 50))) {
-                    tool.initXMemoryTools(g_pkgNameBuffer, MODE_ROOT);
+                    tool.initXMemoryTools(g_pkgNameBuffer, MODE_ROOT, connectError, sizeof(connectError));
                 }
+                if (connectError[0]) ImGui::TextColored(ImVec4(1,0,0,1), "Connect failed: %s", connectError);
 
                 ImGui::EndTabItem();
             }
@@ -260,15 +351,66 @@ void DrawMemoryToolWindow() {
                     ImGui::Combo("Data Type", &g_selectedType, DATA_TYPE_NAMES, IM_ARRAYSIZE(DATA_TYPE_NAMES));
                     
                     const char* ranges[] = { "ALL", "B_BAD", "C_ALLOC", "C_BSS", "C_DATA", "C_HEAP", "JAVA_HEAP", "A_ANON", "CODE_SYSTEM", "STACK", "ASHMEM" };
-                    if (ImGui::Combo("Memory Range", &tool.m_searchRange, ranges, IM_ARRAYSIZE(ranges))) {
-                        tool.SetSearchRange(tool.m_searchRange);
+                    // Jobs read these settings mid-scan, so they are atomics edited through local copies
+                    int searchRange = tool.m_searchRange;
+                    if (ImGui::Combo("Memory Range", &searchRange, ranges, IM_ARRAYSIZE(ranges))) {
+                        tool.SetSearchRange(searchRange);
                     }
                     
                     // Safe Mode Toggle
-                    if (ImGui::Checkbox("Safe Mode (Slow & Stealth)", &tool.m_safeMode)) {
-                        // Toggle logic handled by boolean ref
-                    }
+                    bool safeMode = tool.m_safeMode;
+                    if (ImGui::Checkbox("Safe Mode (Slow & Stealth)", &safeMode)) tool.m_safeMode = safeMode;
                     if (ImGui::IsItemHovered()) ImGui::SetTooltip("Slows down scan to prevent CPU spikes/detection.");
+
+                    bool captureValues = tool.m_captureValues;
+                    if (ImGui::Checkbox("Remember Values", &captureValues)) tool.m_captureValues = captureValues;
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Keeps each result's value so the next pass can refine by changed / increased / decreased.");
+
+                    bool pageHashSkip = tool.m_pageHashSkip;
+                    if (ImGui::Checkbox("Skip Unchanged Pages", &pageHashSkip)) tool.m_pageHashSkip = pageHashSkip;
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("User-side rescans hash each page and reuse the last hits of pages that did not change.");
+
+                    int readAhead = tool.m_readAhead;
+                    ImGui::SetNextItemWidth(120);
+                    if (ImGui::InputInt("Read Ahead", &readAhead)) tool.m_readAhead = std::max(1, std::min(readAhead, 64));
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Chunks read ahead while the previous one is compared (1 = no overlap).");
+                    ImGui::SameLine();
+                    int readerThreads = tool.m_readerThreads;
+                    ImGui::SetNextItemWidth(120);
+                    if (ImGui::InputInt("Readers", &readerThreads)) tool.m_readerThreads = std::max(1, std::min(readerThreads, 8));
+
+                    // Item 0 is the tuned size, item i the tuner's size i - 1
+                    static const char* chunkSizes[] = { "Auto", "16 KB", "32 KB", "64 KB", "128 KB", "256 KB", "512 KB", "1 MB" };
+                    int readChunk = tool.m_chunkOverride ? ChunkTuner::IndexOf(tool.m_chunkOverride) + 1 : 0;
+                    ImGui::SetNextItemWidth(120);
+                    if (ImGui::Combo("Read Chunk", &readChunk, chunkSizes, IM_ARRAYSIZE(chunkSizes))) {
+                        tool.m_chunkOverride = readChunk ? ChunkTuner::SizeOf(readChunk - 1) : 0;
+                    }
+                    ImGui::SameLine();
+                    int searchSlice = tool.m_sliceOverride ? ChunkTuner::IndexOf(tool.m_sliceOverride) + 1 : 0;
+                    ImGui::SetNextItemWidth(120);
+                    if (ImGui::Combo("Search Slice", &searchSlice, chunkSizes, IM_ARRAYSIZE(chunkSizes))) {
+                        tool.m_sliceOverride = searchSlice ? ChunkTuner::SizeOf(searchSlice - 1) : 0;
+                    }
+                    bool adaptChunks = tool.m_adaptChunks;
+                    if (ImGui::Checkbox("Adapt Chunk Sizes", &adaptChunks)) tool.m_adaptChunks = adaptChunks;
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Auto sizes follow measured scan throughput, stepping down when reads hit unreadable pages.");
+                    ImGui::SameLine();
+                    if (ImGui::Button("Retune")) tool.SubmitJob("Autotune", []() { tool.AutotuneChunks(true); }, OnJobDone);
+                    size_t tunedRead, tunedSlice;
+                    tool.GetTunedSizes(tunedRead, tunedSlice);
+                    if (tunedRead) ImGui::Text("Tuned: read %zu KB, slice %zu KB", tunedRead / 1024, tunedSlice / 1024);
+                    else ImGui::TextDisabled("Tuned: not yet, sizes are tuned on connect");
+
+                    bool lockScratch = tool.m_arena.IsLocked();
+                    if (ImGui::Checkbox("Lock Scan Buffers", &lockScratch)) tool.m_arena.SetLocked(lockScratch);
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("mlock the scan's scratch buffers so they are never paged out (needs RLIMIT_MEMLOCK).");
+                    ImGui::SameLine();
+                    if (ImGui::Button("Release Scratch")) tool.m_arena.Trim();
+                    ArenaStats arena = tool.m_arena.Stats();
+                    ImGui::TextDisabled("Scratch: %.1f MB mapped, %.1f MB free, %.1f MB locked%s", arena.bytesMapped / 1048576.0,
+                                        arena.bytesFree / 1048576.0, arena.bytesLocked / 1048576.0,
+                                        arena.lockFailures ? " (mlock refused)" : "");
                 ImGui::EndGroup();
                 
                 ImGui::Separator();
@@ -281,21 +423,78 @@ void DrawMemoryToolWindow() {
                 
                 ImGui::Spacing();
                 
-                // Action Buttons
+                // Action Buttons (queued on the job thread, the overlay keeps drawing)
                 if (ImGui::Button("NEW SCAN", ImVec2(150, 50))) {
-                    tool.MemorySearch(g_searchValBuffer, g_selectedType);
+                    tool.SubmitSearch(g_searchValBuffer, g_selectedType, OnJobDone);
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("REFINE (Next)", ImVec2(150, 50))) {
-                     tool.MemoryOffset(g_searchValBuffer, 0, g_selectedType); 
+                     tool.SubmitRefine(g_searchValBuffer, 0, g_selectedType, OnJobDone); 
                 }
                 ImGui::SameLine();
                 if (ImGui::Button("CLEAR", ImVec2(100, 50))) {
-                    tool.ClearResults();
+                    tool.SubmitJob("Clear", []() { tool.ClearResults(); }, OnJobDone);
                 }
+
+                // Refine history
+                int historyPos = tool.GetHistoryPos();
+                int historyDepth = tool.GetHistoryDepth();
+                if (ImGui::Button("UNDO", ImVec2(100, 40)) && historyPos > 0) {
+                    tool.SubmitJob("Undo", []() { tool.UndoResults(); }, OnJobDone);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("REDO", ImVec2(100, 40)) && historyPos + 1 < historyDepth) {
+                    tool.SubmitJob("Redo", []() { tool.RedoResults(); }, OnJobDone);
+                }
+                ImGui::SameLine();
+                if (historyDepth > 0) {
+                    char historyLabel[96];
+                    tool.GetHistoryLabel(historyPos, historyLabel, sizeof(historyLabel));
+                    ImGui::TextDisabled("Step %d/%d: %s", historyPos + 1, historyDepth, historyLabel);
+                }
+
+                // Compare against the values seen by the last scan / refine ("By" modes use the Value box)
+                static int compareMode = COMPARE_CHANGED;
+                const char* compareModes[] = { "Changed", "Unchanged", "Increased", "Decreased", "Increased By", "Decreased By" };
+                ImGui::PushItemWidth(200);
+                ImGui::Combo("##CompareMode", &compareMode, compareModes, IM_ARRAYSIZE(compareModes));
+                ImGui::PopItemWidth();
+                ImGui::SameLine();
+                if (ImGui::Button("COMPARE", ImVec2(150, 0))) {
+                    tool.SubmitCompare(compareMode, g_searchValBuffer, OnJobDone);
+                }
+
+                // Streaming scans: run in constant memory and keep the current results
+                if (ImGui::Button("COUNT", ImVec2(150, 40))) {
+                    tool.SubmitSearchTo("Count", g_searchValBuffer, g_selectedType, std::make_shared<CountSink>(), OnStreamJobDone);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("SCAN & WRITE", ImVec2(150, 40))) {
+                    auto sink = std::make_shared<WriteSink>(tool.kpm, g_writeValBuffer, g_selectedType);
+                    tool.SubmitSearchTo("Scan & Write", g_searchValBuffer, g_selectedType, sink, OnStreamJobDone);
+                }
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Writes the Results tab's Write Value to every hit.");
                 
+                ImGui::Spacing();
+                DrawJobStatus();
                 ImGui::Spacing();
                 ImGui::TextColored(ImVec4(1,1,0,1), "Results found: %d", tool.GetResultCount());
+                ScanStats scan = tool.GetLastScan();
+                ImGui::TextDisabled("Last scan: %.1f ms, %llu driver calls, %llu overflow resumptions", scan.elapsedMs,
+                                    (unsigned long long)scan.driverCalls, (unsigned long long)scan.resumptions);
+                if (scan.pipeline.readers) {
+                    // Whichever side waits more is the faster one: the other stage limits throughput
+                    ImGui::TextDisabled("Pipeline x%u: readers waited %llu (%.0f ms), compare waited %llu (%.0f ms)", scan.pipeline.depth,
+                                        (unsigned long long)scan.pipeline.readerStalls, scan.pipeline.readerWaitMs,
+                                        (unsigned long long)scan.pipeline.compareStalls, scan.pipeline.compareWaitMs);
+                }
+                if (scan.pagesTotal) {
+                    ImGui::TextDisabled("Unchanged pages reused: %llu of %llu", (unsigned long long)scan.pagesReused,
+                                        (unsigned long long)scan.pagesTotal);
+                }
+                ImGui::TextDisabled("Page faults: %llu minor, %llu major; scratch buffers reused: %llu of %llu",
+                                    (unsigned long long)scan.minorFaults, (unsigned long long)scan.majorFaults,
+                                    (unsigned long long)scan.scratchReuses, (unsigned long long)scan.scratchAcquires);
                 
                 ImGui::EndTabItem();
             }
@@ -304,6 +503,7 @@ void DrawMemoryToolWindow() {
             // TAB 3: RESULTS & EDIT
             // ==========================================================
             if (ImGui::BeginTabItem("Results")) {
+                g_resultsShown = true;
                 ImGui::Spacing();
                 
                 // Batch Edit
@@ -312,83 +512,503 @@ void DrawMemoryToolWindow() {
                     CheckSetFocus(g_writeValBuffer, sizeof(g_writeValBuffer));
                     ImGui::SameLine();
                     if (ImGui::Button("Write All", ImVec2(120, 0))) {
-                         tool.MemoryWrite(g_writeValBuffer, 0, g_selectedType);
+                         tool.SubmitWrite(g_writeValBuffer, 0, g_selectedType, OnJobDone);
                     }
                 ImGui::EndGroup();
+                DrawJobStatus();
+
+                // Named result sets: save the current results, then combine later ones with them
+                if (ImGui::CollapsingHeader("Saved Sets")) {
+                    static char setName[64] = "set1";
+                    ImGui::InputText("##SetName", setName, sizeof(setName));
+                    CheckSetFocus(setName, sizeof(setName));
+                    ImGui::SameLine();
+                    if (ImGui::Button("Save Current")) {
+                        std::string name = setName;
+                        tool.SubmitJob("Save Set", [name]() { tool.SaveResultSet(name.c_str()); }, OnJobDone);
+                    }
+
+                    static std::vector<std::pair<std::string, size_t>> sets; // Kept so refills don't allocate
+                    tool.GetResultSets(sets);
+                    std::string deleteSet;
+                    for (const auto& set : sets) {
+                        ImGui::PushID(set.first.c_str());
+                        ImGui::Text("%s (%zu)", set.first.c_str(), set.second);
+                        ImGui::SameLine();
+                        if (ImGui::SmallButton("Load")) {
+                            std::string name = set.first;
+                            tool.SubmitJob("Load Set", [name]() { tool.LoadResultSet(name.c_str()); }, OnJobDone);
+                        }
+                        ImGui::SameLine();
+                        if (ImGui::SmallButton("And")) tool.SubmitCombine(SET_INTERSECT, set.first.c_str(), OnJobDone);
+                        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Keep results that are also in this set");
+                        ImGui::SameLine();
+                        if (ImGui::SmallButton("Or")) tool.SubmitCombine(SET_UNION, set.first.c_str(), OnJobDone);
+                        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Add this set's results");
+                        ImGui::SameLine();
+                        if (ImGui::SmallButton("Minus")) tool.SubmitCombine(SET_DIFFERENCE, set.first.c_str(), OnJobDone);
+                        if (ImGui::IsItemHovered()) ImGui::SetTooltip("Drop results that are in this set");
+                        ImGui::SameLine();
+                        if (ImGui::SmallButton("X")) deleteSet = set.first;
+                        ImGui::PopID();
+                    }
+                    if (!deleteSet.empty()) tool.DeleteResultSet(deleteSet.c_str());
+
+                    // Current results to / from disk. Files only load into the process they were saved from.
+                    static char resultsPath[128] = "/data/local/tmp/memtool_results.bin";
+                    static bool forceLoad = false;
+                    ImGui::InputText("##ResultsPath", resultsPath, sizeof(resultsPath));
+                    CheckSetFocus(resultsPath, sizeof(resultsPath));
+                    if (ImGui::Button("Save to File")) {
+                        std::string path = resultsPath;
+                        tool.SubmitJob("Save File", [path]() {
+                            g_fileStatus = tool.SaveResultsFile(path.c_str()) ? FILE_LOAD_OK : FILE_LOAD_BAD_FILE;
+                        }, OnFileJobDone);
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::Button("Load from File")) {
+                        std::string path = resultsPath;
+                        bool force = forceLoad;
+                        tool.SubmitJob("Load File", [path, force]() {
+                            g_fileStatus = tool.LoadResultsFile(path.c_str(), nullptr, force);
+                        }, OnFileJobDone);
+                    }
+                    ImGui::SameLine();
+                    ImGui::Checkbox("Force", &forceLoad);
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Load files saved from another run of the target too");
+                }
+
+                static int refreshRate = tool.m_valueCache.Rate();
+                ImGui::SetNextItemWidth(200);
+                if (ImGui::InputInt("Refresh (Hz)", &refreshRate, 1, 10)) {
+                    refreshRate = std::max(1, std::min(refreshRate, ValueCache::MAX_RATE));
+                    tool.m_valueCache.SetRate(refreshRate);
+                }
+                ImGui::SameLine();
+                ImGui::TextDisabled("%.0fus per refresh", tool.m_valueCache.RoundUs());
 
                 ImGui::Separator();
                 
-                // List
-                ImGui::BeginChild("ResultsScroll", ImVec2(0, 0), true); // Fill remaining space
+                std::lock_guard<std::mutex> resultsLock(tool.m_resultsMutex); // A finishing job swaps m_results
                 const auto& results = tool.GetResults();
-                
-                // Display Columns
-                ImGui::Columns(4, "ResCols"); 
-                ImGui::Text("Address"); ImGui::NextColumn();
-                ImGui::Text("Value"); ImGui::NextColumn();
-                ImGui::Text("Type/Map"); ImGui::NextColumn();
-                ImGui::Text("Action"); ImGui::NextColumn();
-                ImGui::Separator();
 
-                int count = 0;
-                for (const auto& res : results) {
-                    std::string valStr = tool.GetAddressValue(res.addr, res.type);
-                    
-                    // Col 1: Addr
-                    ImGui::Text("0x%lX", res.addr); 
-                    ImGui::NextColumn();
-                    
-                    // Col 2: Value
-                    ImGui::TextColored(ImVec4(1,1,0,1), "%s", valStr.c_str());
-                    ImGui::NextColumn();
-                    
-                    // Col 3: Info
-                    ImGui::TextDisabled("%s", (res.mapName.empty() ? "?" : res.mapName.c_str()));
-                    ImGui::NextColumn();
-                    
-                    // Col 4: Action
-                    if (ImGui::Button(("Frz##" + std::to_string(res.addr)).c_str())) {
-                         tool.AddFreezeItem(res.addr, valStr.c_str(), res.type);
-                         tool.StartFreeze();
+                // Navigation: the table shows one page of rows at a time so that row positions stay
+                // exact in ImGui's float coordinates however large the result set gets
+                static const size_t PAGE_ROWS = 100000;
+                static size_t pageBase = 0;
+                static size_t jumpRow = SIZE_MAX; // Row to scroll to and highlight next frame
+                static size_t highlightRow = SIZE_MAX;
+
+                // Sort & filter: the table pages through the engine's sorted index when there is one.
+                // A view that went stale because the rows changed is rebuilt with the same query.
+                static ViewQuery viewQuery;
+                static bool viewActive = false;  // A query is applied
+                static bool viewWanted = false;  // Build it once the job thread is free
+                static bool viewPending = false; // A build is queued or running
+                if (ImGui::CollapsingHeader("Sort & Filter")) {
+                    static const char* sortNames[] = { "Address", "Value", "Region", "Changes" };
+                    static char regionFilter[64] = "";
+                    static char addrMin[32] = "";
+                    static char addrMax[32] = "";
+                    static ViewQuery editQuery;
+                    ImGui::SetNextItemWidth(200);
+                    ImGui::Combo("Sort By", &editQuery.sortKey, sortNames, IM_ARRAYSIZE(sortNames));
+                    ImGui::SameLine();
+                    ImGui::Checkbox("Descending", &editQuery.descending);
+                    ImGui::SetNextItemWidth(300);
+                    ImGui::InputText("Map Contains", regionFilter, sizeof(regionFilter));
+                    CheckSetFocus(regionFilter, sizeof(regionFilter));
+                    ImGui::SetNextItemWidth(200);
+                    ImGui::InputText("##AddrMin", addrMin, sizeof(addrMin));
+                    CheckSetFocus(addrMin, sizeof(addrMin));
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(200);
+                    ImGui::InputText("Address Range##AddrMax", addrMax, sizeof(addrMax));
+                    CheckSetFocus(addrMax, sizeof(addrMax));
+                    ImGui::Checkbox("Value Between", &editQuery.valueFilter);
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(180);
+                    ImGui::InputDouble("##ValueMin", &editQuery.valueMin);
+                    ImGui::SameLine();
+                    ImGui::SetNextItemWidth(180);
+                    ImGui::InputDouble("##ValueMax", &editQuery.valueMax);
+
+                    if (ImGui::Button("Apply")) {
+                        editQuery.regionFilter = regionFilter;
+                        editQuery.addrMin = addrMin[0] ? strtoull(addrMin, nullptr, 16) : 0;
+                        editQuery.addrMax = addrMax[0] ? strtoull(addrMax, nullptr, 16) : ~(ADDRESS)0;
+                        viewQuery = editQuery;
+                        viewActive = viewWanted = true;
                     }
-                    ImGui::NextColumn();
-                    
-                    if (++count > 200) { // Limit view
-                        ImGui::Columns(1);
-                        ImGui::TextDisabled("... %d more results hidden ...", (int)results.size() - 200);
-                        break;
+                    ImGui::SameLine();
+                    if (ImGui::Button("Refresh Values")) viewWanted = viewActive; // A rebuild re-reads, counting changes
+                    ImGui::SameLine();
+                    if (ImGui::Button("Reset")) {
+                        viewActive = viewWanted = false;
+                        tool.ClearResultView();
+                    }
+                    if (const ResultView* view = tool.GetResultView()) {
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("%zu of %zu rows, built in %.0f ms", view->rows.size(), results.Size(), view->buildMs);
                     }
                 }
-                ImGui::Columns(1);
-                ImGui::EndChild();
-                
+                if (viewActive && !viewPending && !tool.GetResultView()) viewWanted = true; // Rows changed under it
+                if (viewWanted && !viewPending && !tool.IsBusy()) {
+                    viewPending = true;
+                    viewWanted = false;
+                    tool.SubmitResultView(viewQuery, [](const ScanJob& job) {
+                        viewPending = false;
+                        if (job.cancelled) viewActive = false;
+                        OnJobDone(job);
+                    });
+                }
+                const ResultView* view = tool.GetResultView();
+                const size_t viewRows = view ? view->rows.size() : results.Size();
+                if (pageBase >= viewRows) pageBase = 0;
+
+                // Table position of the first shown row in [first, end) of m_results, SIZE_MAX if none.
+                // Scan order needs no search; a sorted view is searched once per jump.
+                auto positionOf = [&](size_t first, size_t end) -> size_t {
+                    if (!view) return first < end ? first : SIZE_MAX;
+                    for (size_t k = 0; k < view->rows.size(); k++) {
+                        if (view->rows[k] >= first && view->rows[k] < end) return k;
+                    }
+                    return SIZE_MAX;
+                };
+
+                static char jumpAddr[32] = "";
+                ImGui::SetNextItemWidth(250);
+                bool jump = ImGui::InputText("##JumpAddr", jumpAddr, sizeof(jumpAddr), ImGuiInputTextFlags_EnterReturnsTrue);
+                CheckSetFocus(jumpAddr, sizeof(jumpAddr));
+                ImGui::SameLine();
+                if ((ImGui::Button("Go to Address") || jump) && !results.Empty()) {
+                    ADDRESS addr = strtoull(jumpAddr, nullptr, 16);
+                    size_t row = std::min(results.LowerBound(addr), results.Size() - 1);
+                    jumpRow = positionOf(row, row + 1);
+                }
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(-1);
+                if (ImGui::BeginCombo("##JumpRegion", "Go to Region")) {
+                    // One entry per run of rows from the same map; only the visible entries are laid out
+                    ImGuiListClipper regionClipper;
+                    regionClipper.Begin((int)std::min<size_t>(results.RegionRunCount(), INT_MAX));
+                    while (regionClipper.Step()) {
+                        for (int r = regionClipper.DisplayStart; r < regionClipper.DisplayEnd; r++) {
+                            size_t first = results.RegionRunFirstRow(r);
+                            const std::string& name = results.RegionRunName(r);
+                            char label[160];
+                            snprintf(label, sizeof(label), "%s @0x%lX (row %zu)##%d", name.empty() ? "?" : name.c_str(),
+                                     (unsigned long)results.Addr(first), first, r);
+                            size_t end = r + 1 < (int)results.RegionRunCount() ? results.RegionRunFirstRow(r + 1) : results.Size();
+                            if (ImGui::Selectable(label)) jumpRow = positionOf(first, end);
+                        }
+                    }
+                    ImGui::EndCombo();
+                }
+
+                if (jumpRow != SIZE_MAX) {
+                    pageBase = jumpRow - jumpRow % PAGE_ROWS;
+                    highlightRow = jumpRow;
+                }
+                size_t pageEnd = std::min(pageBase + PAGE_ROWS, viewRows);
+                if (viewRows > PAGE_ROWS) {
+                    if (ImGui::ArrowButton("##PrevPage", ImGuiDir_Left) && pageBase > 0) pageBase -= PAGE_ROWS;
+                    ImGui::SameLine();
+                    if (ImGui::ArrowButton("##NextPage", ImGuiDir_Right) && pageEnd < viewRows) pageBase += PAGE_ROWS;
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("Rows %zu-%zu of %zu", pageBase, pageEnd, viewRows);
+                    pageEnd = std::min(pageBase + PAGE_ROWS, viewRows);
+                }
+
+                // Values come from the value cache, which reads the rows laid out here off this thread
+                static ADDRESS rowAddrs[ValueCache::MAX_ROWS];
+                static int rowTypes[ValueCache::MAX_ROWS];
+                static ValueCache::Value rowValues[ValueCache::MAX_ROWS];
+                size_t cachedRows = tool.m_valueCache.Read(rowValues, ValueCache::MAX_ROWS);
+                size_t shownRows = 0;
+
+                const ImGuiTableFlags tableFlags = ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg |
+                                                   ImGuiTableFlags_BordersOuter | ImGuiTableFlags_BordersInnerV |
+                                                   ImGuiTableFlags_Resizable;
+                if (ImGui::BeginTable("ResTable", 4, tableFlags, ImVec2(0, 0))) { // Fill remaining space
+                    ImGui::TableSetupScrollFreeze(0, 1);
+                    ImGui::TableSetupColumn("Address");
+                    ImGui::TableSetupColumn("Value");
+                    ImGui::TableSetupColumn("Type/Map");
+                    ImGui::TableSetupColumn("Action");
+                    ImGui::TableHeadersRow();
+
+                    // Fixed row height, so that a row's position is its index times it
+                    const float rowHeight = ImGui::GetFrameHeight() + ImGui::GetStyle().CellPadding.y * 2;
+                    if (jumpRow != SIZE_MAX) {
+                        ImGui::SetScrollY((jumpRow - pageBase) * rowHeight - ImGui::GetWindowHeight() / 2);
+                        jumpRow = SIZE_MAX;
+                    }
+
+                    ImGuiListClipper clipper;
+                    clipper.Begin((int)(pageEnd - pageBase), rowHeight);
+                    while (clipper.Step()) {
+                        for (int r = clipper.DisplayStart; r < clipper.DisplayEnd; r++) {
+                            size_t i = view ? view->rows[pageBase + r] : pageBase + r;
+                            ADDRESS addr = results.Addr(i);
+                            int rowType = results.RowType(i); // AUTO rows show their first matched type
+                            if (shownRows < ValueCache::MAX_ROWS) {
+                                rowAddrs[shownRows] = addr;
+                                rowTypes[shownRows] = rowType;
+                                shownRows++;
+                            }
+                            const ValueCache::Value* cached = ValueCache::Find(rowValues, cachedRows, addr, rowType);
+                            const char* valStr = cached ? cached->text : "...";
+
+                            ImGui::TableNextRow(0, rowHeight);
+                            if (pageBase + r == highlightRow) ImGui::TableSetBgColor(ImGuiTableBgTarget_RowBg1, IM_COL32(80, 80, 0, 160));
+                            ImGui::PushID(r);
+
+                            // Col 1: Addr
+                            ImGui::TableNextColumn();
+                            ImGui::Text("0x%lX", addr);
+
+                            // Col 2: Value
+                            ImGui::TableNextColumn();
+                            ImGui::TextColored(ImVec4(1,1,0,1), "%s", valStr);
+
+                            // Col 3: Info
+                            ImGui::TableNextColumn();
+                            const std::string& mapName = results.RegionName(i);
+                            if (results.HasTypeMasks()) {
+                                char typeNames[64] = "";
+                                for (uint32_t m = results.TypeMask(i); m; m &= m - 1) {
+                                    if (typeNames[0]) strncat(typeNames, "|", sizeof(typeNames) - strlen(typeNames) - 1);
+                                    strncat(typeNames, DATA_TYPE_NAMES[__builtin_ctz(m)], sizeof(typeNames) - strlen(typeNames) - 1);
+                                }
+                                ImGui::TextDisabled("%s %s", typeNames, (mapName.empty() ? "?" : mapName.c_str()));
+                            } else {
+                                ImGui::TextDisabled("%s", (mapName.empty() ? "?" : mapName.c_str()));
+                            }
+                            if (uint32_t changes = tool.GetChangeCount(i)) {
+                                ImGui::SameLine();
+                                ImGui::TextDisabled("changed %ux", changes);
+                            }
+
+                            // Col 4: Action
+                            ImGui::TableNextColumn();
+                            if (ImGui::SmallButton("Frz")) {
+                                 if (cached && cached->valid) tool.AddFreezeItem(addr, valStr, rowType);
+                                 tool.StartFreeze();
+                            }
+                            ImGui::SameLine();
+                            if (ImGui::SmallButton("Watch")) {
+                                 tool.AddWatchItem(addr, rowType);
+                                 tool.StartWatch();
+                            }
+                            ImGui::PopID();
+                        }
+                    }
+                    ImGui::EndTable();
+                }
+                tool.m_valueCache.SetRows(rowAddrs, rowTypes, shownRows);
+
                 ImGui::EndTabItem();
             }
             
             // ==========================================================
-            // TAB 4: FROZEN LIST
+            // TAB 4: WATCH LIST
+            // ==========================================================
+            if (ImGui::BeginTabItem("Watch")) {
+                g_watchShown = true;
+                static int watchRate = tool.m_watchRateHz;
+                ImGui::SetNextItemWidth(200);
+                if (ImGui::InputInt("Rate (Hz)", &watchRate, 10, 100)) {
+                    watchRate = std::max(1, std::min(watchRate, MemoryTool::MAX_WATCH_RATE));
+                    tool.SetWatchRate(watchRate);
+                }
+                ImGui::SameLine();
+                if (tool.m_isWatching) {
+                    if (ImGui::Button("Pause")) tool.StopWatch();
+                } else {
+                    if (ImGui::Button("Sample")) tool.StartWatch();
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Clear")) {
+                    tool.StopWatch();
+                    tool.ClearWatchItems();
+                }
+
+                static char watchAddr[32] = "";
+                static int watchType = TYPE_DWORD;
+                ImGui::SetNextItemWidth(250);
+                ImGui::InputText("##WatchAddr", watchAddr, sizeof(watchAddr));
+                CheckSetFocus(watchAddr, sizeof(watchAddr));
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(150);
+                ImGui::Combo("##WatchType", &watchType, DATA_TYPE_NAMES, TYPE_AUTO); // No AUTO: a watch has one type
+                ImGui::SameLine();
+                if (ImGui::Button("Add")) {
+                    ADDRESS addr = strtoull(watchAddr, nullptr, 16);
+                    if (addr && tool.AddWatchItem(addr, watchType)) tool.StartWatch();
+                }
+
+                WatchStats ws = tool.GetWatchStats();
+                ImGui::TextDisabled("%zu items in %zu reads (%zu pages): %.0f Hz of %d, %.0fus per round, %llu skipped",
+                                    ws.items, ws.spans, ws.pages, ws.achievedHz, ws.rateHz, ws.roundUs,
+                                    (unsigned long long)ws.missedRounds);
+
+                // What writes: hardware watchpoint on one item, started from its row
+                static bool traceReads = false;
+                if (ImGui::CollapsingHeader("Access Trace")) {
+                    ImGui::Checkbox("Reads Too", &traceReads);
+                    if (ImGui::IsItemHovered()) ImGui::SetTooltip("Traces every access instead of writes only; the next trace uses it.");
+                    ImGui::SameLine();
+                    if (tool.m_tracer.IsRunning()) {
+                        if (ImGui::Button("Stop Trace")) tool.m_tracer.Stop();
+                        ImGui::SameLine();
+                        if (ImGui::Button("Reset Counts")) tool.m_tracer.ClearSites();
+                    }
+                    TraceStats ts = tool.m_tracer.Stats();
+                    char traceError[128];
+                    tool.m_tracer.LastError(traceError, sizeof(traceError));
+                    if (traceError[0]) ImGui::TextColored(ImVec4(1,0.3f,0.3f,1), "%s", traceError);
+                    if (tool.m_tracer.Address()) {
+                        ImGui::TextDisabled("%s of 0x%lX%s: %zu threads, %llu hits, %llu lost, %llu throttled",
+                                            tool.m_tracer.Kind() == TRACE_WRITES ? "Writes" : "Accesses",
+                                            (unsigned long)tool.m_tracer.Address(), tool.m_tracer.IsRunning() ? "" : " (stopped)",
+                                            ts.threads, (unsigned long long)ts.samples, (unsigned long long)ts.lost,
+                                            (unsigned long long)ts.throttles);
+                    }
+                    static std::vector<AccessSite> sites;
+                    tool.m_tracer.Sites(sites);
+                    for (const auto& site : sites) {
+                        ImGui::Text("%8llu", (unsigned long long)site.hits);
+                        ImGui::SameLine();
+                        if (site.module.empty()) ImGui::TextColored(ImVec4(0,1,1,1), "0x%lX", (unsigned long)site.pc);
+                        else ImGui::TextColored(ImVec4(0,1,1,1), "%s+0x%llX", site.module.c_str(), (unsigned long long)site.offset);
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("(0x%lX, %u threads)", (unsigned long)site.pc, site.threads);
+                    }
+                }
+
+                ImGui::Separator();
+
+                ImGui::BeginChild("WatchScroll");
+                // Newest samples of one item at a time; the plot shows at most PLOT_SAMPLES of them
+                static const size_t PLOT_SAMPLES = 512;
+                static int64_t times[PLOT_SAMPLES];
+                static double values[PLOT_SAMPLES];
+                static float plot[PLOT_SAMPLES];
+                static std::vector<std::shared_ptr<WatchItem>> watchItems;
+                tool.GetWatchItems(watchItems);
+                ADDRESS removeAddr = 0;
+                for (const auto& item : watchItems) {
+                    ImGui::PushID((void*)(uintptr_t)item->addr);
+                    size_t n = item->samples.Read(times, values, PLOT_SAMPLES);
+                    ImGui::Text("0x%lX %s", (unsigned long)item->addr, DATA_TYPE_NAMES[item->type]);
+                    ImGui::SameLine();
+                    if (n == 0) {
+                        ImGui::TextDisabled("no samples (%llu failed reads)", (unsigned long long)item->failedReads.load());
+                    } else {
+                        double lo = values[0], hi = values[0];
+                        for (size_t k = 0; k < n; k++) {
+                            lo = std::min(lo, values[k]);
+                            hi = std::max(hi, values[k]);
+                            plot[k] = (float)values[k];
+                        }
+                        double span = (times[n - 1] - times[0]) / 1e9;
+                        double rate = span > 0 ? (values[n - 1] - values[0]) / span : 0.0;
+                        ImGui::TextColored(ImVec4(1,1,0,1), "= %g", values[n - 1]);
+                        ImGui::SameLine();
+                        ImGui::TextDisabled("min %g max %g  %+g/s over %.2fs", lo, hi, rate, span);
+                        ImGui::PlotLines("##plot", plot, (int)n, 0, nullptr, (float)lo, (float)hi, ImVec2(-60, 60));
+                    }
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("Trace")) tool.TraceAccess(item->addr, item->type, traceReads ? TRACE_ACCESSES : TRACE_WRITES);
+                    ImGui::SameLine();
+                    if (ImGui::SmallButton("X")) removeAddr = item->addr;
+                    ImGui::PopID();
+                }
+                if (removeAddr) tool.RemoveWatchItem(removeAddr);
+                ImGui::EndChild();
+                watchItems.clear(); // Don't keep removed items alive until the tab is drawn again
+
+                ImGui::EndTabItem();
+            }
+
+            // ==========================================================
+            // TAB 5: FROZEN LIST
             // ==========================================================
             if (ImGui::BeginTabItem("Frozen")) {
                 if (ImGui::Button("Stop & Clear All Freeze", ImVec2(-1, 40))) {
                      tool.StopFreeze();
                      tool.ClearFreezeItems();
                 }
+
+                static char freezePath[128] = "/data/local/tmp/memtool_freeze.bin";
+                ImGui::InputText("##FreezePath", freezePath, sizeof(freezePath));
+                CheckSetFocus(freezePath, sizeof(freezePath));
+                ImGui::SameLine();
+                if (ImGui::Button("Save List")) {
+                    std::string path = freezePath;
+                    tool.SubmitJob("Save List", [path]() {
+                        g_fileStatus = tool.SaveFreezeFile(path.c_str()) ? FILE_LOAD_OK : FILE_LOAD_BAD_FILE;
+                    }, OnFileJobDone);
+                }
+                ImGui::SameLine();
+                if (ImGui::Button("Load List")) {
+                    std::string path = freezePath;
+                    tool.SubmitJob("Load List", [path]() { g_fileStatus = tool.LoadFreezeFile(path.c_str()); }, OnFileJobDone);
+                }
+                DrawJobStatus();
+
+                bool freezeCompare = tool.m_freezeCompare; // Read by the freeze thread every tick
+                if (ImGui::Checkbox("Write Only Changed Values", &freezeCompare)) tool.m_freezeCompare = freezeCompare;
+                if (ImGui::IsItemHovered()) ImGui::SetTooltip("Batch-reads frozen values each tick and only rewrites the ones the game changed.");
+
+                static int defaultPeriod = tool.m_freezeDelay;
+                if (ImGui::InputInt("Default Period (us)", &defaultPeriod, 1000, 10000)) {
+                    if (defaultPeriod < 100) defaultPeriod = 100;
+                    tool.SetFreezeDelay(defaultPeriod);
+                }
+
+                // Scheduler stats, one line per period group
+                static std::vector<FreezeStats> freezeStats;
+                tool.GetFreezeStats(freezeStats);
+                for (const auto& st : freezeStats) {
+                    ImGui::TextDisabled("%dus x%zu: got %.0fus  jitter p50 %.0fus p99 %.0fus max %.0fus  overruns %llu",
+                                        st.periodUs, st.itemCount, st.achievedPeriodUs, st.jitterP50Us,
+                                        st.jitterP99Us, st.jitterMaxUs, (unsigned long long)st.overruns);
+                }
                 
                 ImGui::Separator();
                 
                 ImGui::BeginChild("FreezeScroll");
-                const auto& frozen = tool.m_freezeItems;
-                for (const auto& item : frozen) {
-                     ImGui::Text("0x%lX", item.addr);
-                     ImGui::SameLine();
-                     ImGui::TextColored(ImVec4(0,1,1,1), "= %s", item.value.c_str());
-                     ImGui::SameLine();
-                     if (ImGui::SmallButton(("X##" + std::to_string(item.addr)).c_str())) {
-                         tool.RemoveFreezeItem(item.addr);
-                         if(frozen.empty()) tool.StopFreeze(); // Auto stop if empty
-                         break; // Break loop to avoid iterator invalidation
-                     }
+                ADDRESS removeAddr = 0;
+                ADDRESS periodAddr = 0;
+                int newPeriod = 0;
+                {
+                    std::lock_guard<std::mutex> lock(tool.m_freezeMutex);
+                    for (const auto& item : tool.m_freezeItems) {
+                         ImGui::PushID((void*)(uintptr_t)item.addr);
+                         ImGui::Text("0x%lX", item.addr);
+                         ImGui::SameLine();
+                         ImGui::TextColored(ImVec4(0,1,1,1), "= %s", item.value.c_str());
+                         ImGui::SameLine();
+                         ImGui::TextDisabled("(hit %llu)", (unsigned long long)item.overwrites);
+                         ImGui::SameLine();
+                         int period = item.periodUs;
+                         ImGui::SetNextItemWidth(150);
+                         if (ImGui::InputInt("us", &period, 0, 0, ImGuiInputTextFlags_EnterReturnsTrue)) {
+                             periodAddr = item.addr;
+                             newPeriod = period;
+                         }
+                         ImGui::SameLine();
+                         if (ImGui::SmallButton("X")) {
+                             removeAddr = item.addr;
+                         }
+                         ImGui::PopID();
+                    }
                 }
+                // Applied after the loop, both take m_freezeMutex
+                if (periodAddr) tool.SetFreezeItemPeriod(periodAddr, newPeriod);
+                if (removeAddr && tool.RemoveFreezeItem(removeAddr) == 0) tool.StopFreeze(); // Auto stop if empty
                 ImGui::EndChild();
                 
                 ImGui::EndTabItem();
@@ -414,7 +1034,35 @@ void DrawFloatingIcon() {
     ImGui::End();
 }
 
+// Everything between NewFrame and Render; the overlay loop and --bench-ui both draw through it
+void DrawFrame() {
+    // Completion callbacks of background jobs run here, on the UI thread
+    tool.PollJobs();
+    
+    if (g_drawMenu) {
+        // Menu is visible
+        DrawMemoryToolWindow();
+    } else {
+        // Menu is hidden, show icon
+        DrawFloatingIcon();
+    }
+}
+
 int main(int argc, char *argv[]) {
+    // Headless modes
+    if (argc > 1 && strcmp(argv[1], "--bench-kernels") == 0) {
+        return RunScanKernelBenchmark();
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-sets") == 0) {
+        return RunResultSetBenchmark();
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-files") == 0) {
+        return RunResultFileBenchmark(argc > 2 ? argv[2] : "/data/local/tmp/memtool_bench.bin");
+    }
+    if (argc > 1 && strcmp(argv[1], "--bench-ui") == 0) {
+        return RunUiFrameBenchmark(tool, DrawFrame);
+    }
+
     // 1. Initialize Overlay
     if (!initDraw(true)) {
         cout << "Failed to init overlay" << endl;
@@ -423,24 +1071,32 @@ int main(int argc, char *argv[]) {
 
     // 2. Initialize Touch
     // printf("Calling Init_touch_config()...\n");
+    SetTouchListener([](int type) { g_render.Post(type == IM_MOVE ? RENDER_DRAG : RENDER_INPUT); });
+    tool.SetChangeListener([](int event) {
+        g_render.Post((event & EVENT_JOB ? RENDER_JOB : 0) | (event & EVENT_WATCH ? RENDER_WATCH : 0) |
+                      (event & EVENT_VALUES ? RENDER_VALUES : 0));
+    });
     Init_touch_config(); 
 
     // 3. Main Loop
+    // Frames are drawn when something on screen can have changed: input, a worker event the
+    // visible tab shows, or a timer for what nothing posts (progress, stats). See RenderScheduler.
     // printf("Entering Main Loop...\n");
     int frameCount = 0;
+    uint32_t drawnOrientation = displayInfo.orientation;
     while (true) { 
+        int woke = g_render.WaitForFrame();
+        // Hidden menu: the timer only looks for a rotation, which needs the icon laid out again
+        if (!woke && !g_drawMenu) {
+            screen_config();
+            if (displayInfo.orientation == drawnOrientation) continue;
+        }
         // if (frameCount % 600 == 0) printf("Main Loop Tick (Frame %d)...\n", frameCount);
         frameCount++;
 
         drawBegin();
-        
-        if (g_drawMenu) {
-            // Menu is visible
-            DrawMemoryToolWindow();
-        } else {
-            // Menu is hidden, show icon
-            DrawFloatingIcon();
-        }
+        drawnOrientation = displayInfo.orientation;
+        DrawFrame();
         
         // Smart Input Blocking:
         // Automatically Grab input (block game) ONLY when interacting with ImGui windows.
@@ -449,7 +1105,25 @@ int main(int argc, char *argv[]) {
         SetInputGrab(io.WantCaptureMouse);
         
         drawEnd();
-        std::this_thread::sleep_for(16ms); // ~60 FPS cap
+
+        // Touches on the overlay run it at full rate for a moment; touches on the game only
+        // draw the frame that found they missed
+        bool onOverlay = io.WantCaptureMouse && (io.MouseDown[0] || (woke & (RENDER_INPUT | RENDER_DRAG)));
+        if (onOverlay || ImGui::IsAnyItemActive()) g_render.KeepHot();
+        int interest = RENDER_JOB;
+        if (io.MouseDown[0] && io.WantCaptureMouse) interest |= RENDER_DRAG;
+        int timeoutMs = 0;
+        if (g_drawMenu) {
+            if (g_resultsShown) interest |= RENDER_VALUES;
+            if (g_watchShown) interest |= RENDER_WATCH;
+            timeoutMs = 1000; // Memory usage, freeze and watch stats
+            if (g_watchShown && tool.m_tracer.IsRunning()) timeoutMs = 250; // Hit counts
+            if (io.WantTextInput) timeoutMs = 500; // Caret blink
+            if (tool.IsBusy()) timeoutMs = 100; // Progress bar
+        } else {
+            timeoutMs = 1000; // Rotation check only
+        }
+        g_render.SetInterest(interest, timeoutMs);
     }
 
     // 4. Cleanup